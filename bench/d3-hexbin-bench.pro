@@ -0,0 +1,9 @@
+TEMPLATE = app
+CONFIG += console c++11 thread release
+CONFIG -= app_bundle
+CONFIG -= qt
+
+include(../src/d3_hexbin.pri)
+
+SOURCES += \
+    hexbin-bench.cpp
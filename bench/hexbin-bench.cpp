@@ -0,0 +1,101 @@
+#include "d3_hexbin/hexbin.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <sstream>
+
+using datum_t = std::array<double, 2>;
+using data_t  = std::vector<datum_t>;
+using bin_t   = d3_hexbin::HexbinBin<datum_t, double>;
+
+// =============================================================================
+
+// Original std::map<std::string, ...> based binning (before packed keys)
+std::vector<bin_t> mapBins(const data_t& points, double radius) {
+    const auto to_str = [](int val) { std::ostringstream out; out << val; return out.str(); };
+
+    const double dx = radius * 2 * std::sin(d3_hexbin::detail::thirdPi), dy = radius * 1.5;
+    std::map<std::string, bin_t> binsById;
+    for(const auto& point : points) {
+        double px = point[0], py = point[1];
+        if (std::isnan(px) || std::isnan(py)) continue;
+
+        int pj = std::round(py = py / dy);
+        int pi = std::round(px = (px / dx - (pj & 1) / 2.0) +0.00001);
+        const double py1 = py - pj;
+        if (std::abs(py1) * 3 > 1) {
+            const double
+                    px1 = px - pi,
+                    pi2 = pi + (px < pi ? -1 : 1) / 2,
+                    pj2 = pj + (py < pj ? -1 : 1),
+                    px2 = px - pi2,
+                    py2 = py - pj2;
+            if (px1 * px1 + py1 * py1 > px2 * px2 + py2 * py2) { pi = pi2 + (pj & 1 ? 1 : -1) / 2; pj = pj2; }
+        }
+
+        const std::string id = to_str(pi) + "-" + to_str(pj);
+        const auto bin_it = binsById.find(id);
+        if (bin_it != binsById.end()) {
+            bin_it->second.push_back(point);
+        } else {
+            bin_t bin(point);
+            bin.x = (pi + (pj & 1) / 2.0) * dx;
+            bin.y = pj * dy;
+            binsById.insert({id, bin});
+        }
+    }
+
+    std::vector<bin_t> bins;
+    for(const auto& kv : binsById) bins.push_back(kv.second);
+    return bins;
+}
+
+// =============================================================================
+
+template <typename Func>
+void bench(const char* name, std::size_t points_count, const Func& func) {
+    const int repeats = 5;
+    double best = 1e300;
+    std::size_t bins = 0;
+    for(int r = 0; r < repeats; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        bins = func();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    std::printf("  %-28s %10.2f ms  %8.2f ns/point  (%zu bins)\n", name, best, best * 1e6 / points_count, bins);
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    const double size = 1000, radius = 5;
+
+    std::mt19937 gen(42);
+    std::normal_distribution<double> dist(size / 2, size / 6);
+    data_t points(n);
+    for(auto& p : points) p = {dist(gen), dist(gen)};
+
+    std::printf("%zu points, radius %g, extent [0, %g]^2\n", n, radius, size);
+
+    auto b = d3_hexbin::hexbin<datum_t, double>().radius(radius).size({size, size});
+
+    bench("std::map<std::string> (old)", n, [&] { return mapBins(points, radius).size(); });
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const char* order_name = (order == d3_hexbin::HexbinOrder::by_id) ? "by_id" : (order == d3_hexbin::HexbinOrder::first_seen) ? "first_seen" : "by_cell";
+        std::printf("order: %s\n", order_name);
+        b.order(order);
+
+        bench("hash",  n, [&] { return b.engine(d3_hexbin::HexbinEngine::hash)(points).size(); });
+        bench("dense", n, [&] { return b.engine(d3_hexbin::HexbinEngine::dense)(points).size(); });
+        bench("sort",  n, [&] { return b.engine(d3_hexbin::HexbinEngine::sort)(points).size(); });
+        bench("hash counts()",  n, [&] { return b.engine(d3_hexbin::HexbinEngine::hash).counts(points).size(); });
+        bench("dense counts()", n, [&] { return b.engine(d3_hexbin::HexbinEngine::dense).counts(points).size(); });
+        bench("sort counts()",  n, [&] { return b.engine(d3_hexbin::HexbinEngine::sort).counts(points).size(); });
+    }
+
+    return 0;
+}
@@ -2,4 +2,13 @@ INCLUDEPATH += \
     $$PWD
     
 HEADERS += \
-    $$PWD/d3_hexbin/hexbin.hpp
+    $$PWD/d3_hexbin/hexbin.hpp \
+    $$PWD/d3_hexbin/aggregate.hpp \
+    $$PWD/d3_hexbin/quantize.hpp \
+    $$PWD/d3_hexbin/accumulator.hpp \
+    $$PWD/d3_hexbin/window.hpp \
+    $$PWD/d3_hexbin/partial.hpp \
+    $$PWD/d3_hexbin/mapped.hpp \
+    $$PWD/d3_hexbin/csv.hpp \
+    $$PWD/d3_hexbin/tiles.hpp \
+    $$PWD/d3_hexbin/cache.hpp
@@ -0,0 +1,281 @@
+#ifndef D3__HEXBIN__ACCUMULATOR_HPP
+#define D3__HEXBIN__ACCUMULATOR_HPP
+
+#include "hexbin.hpp"
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: incremental binning. Keeps bins between calls, so points,
+    received continuously, are binned once (O(1) amortized per point),
+    instead of re-binning all points by Hexbin::operator() on every update.
+
+    Uses radius, extent, accessors, clip() & order() of specified hexbin
+    (copied on construction). Cells are always looked up in hash table.
+
+    Points may be taken out of bins by remove() & decrement() (for sliding
+    windows), bins which become empty are dropped. Removal of the oldest
+    point of bin is O(1) amortized: bin keeps offset of its first live point
+    and is compacted by snapshot() (or when half of it is removed). With
+    `first_seen` order arrival sequence of each point is kept too, and bins
+    are re-ranked by their first live point, when it is removed (in
+    O(bins * log(bins)), on next snapshot() / ids()).
+
+    @code{.cpp}
+    d3_hexbin::HexbinAccumulator<decltype(hexbin)> acc(hexbin);
+    acc.add(point);
+    acc.add(points.begin(), points.end());
+    const auto& bins = acc.snapshot(); // same as hexbin(all live points)
+    @endcode
+ */
+template <typename HexbinT>
+class HexbinAccumulator
+{
+public:
+
+    using hexbin_t = HexbinT;
+    using datum_t  = typename HexbinT::datum_t;
+    using bin_t    = typename HexbinT::bin_t;
+
+private:
+    HexbinT _hexbin;
+
+    detail::CellTable          _table;
+    std::vector<bin_t>         _bins;
+    std::vector<std::uint64_t> _cells;    // bin slot -> cell
+    std::vector<std::size_t>   _heads;    // bin slot -> removed points at bin front
+    std::vector<std::vector<std::uint64_t>> _seqs; // bin slot -> arrival sequences of points (first_seen only)
+    std::uint64_t              _seq = 0;  // next arrival sequence
+    bool                       _arranged = true;
+    bool                       _trimmed  = false; // some of `_heads` are not 0
+    std::size_t                _dropped = 0; // empty bins, not removed from `_bins` yet
+
+    void _compact(std::size_t slot) {
+        bin_t& bin = _bins[slot];
+        bin.erase(bin.begin(), bin.begin() + _heads[slot]);
+        if (_ranked()) _seqs[slot].erase(_seqs[slot].begin(), _seqs[slot].begin() + _heads[slot]);
+        _heads[slot] = 0;
+    }
+
+    bool _ranked() const {
+        return _hexbin._order == HexbinOrder::first_seen;
+    }
+
+    // Bin slots in order of first live point
+    std::vector<std::size_t> _first_seen_order() const {
+        std::vector<std::size_t> order(_cells.size());
+        for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+        std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+            const bool ea = _bins[a].empty(), eb = _bins[b].empty(); // dropped go last
+            if (ea || eb) return !ea && eb;
+            return _seqs[a][_heads[a]] < _seqs[b][_heads[b]];
+        });
+        return order;
+    }
+
+    void _arrange() {
+        if (_arranged && _dropped == 0) return;
+
+        std::vector<std::size_t> order;
+        if (!_arranged) {
+            order = _ranked() ? _first_seen_order() : _hexbin._ordering(_cells);
+        } else {
+            order.resize(_cells.size());
+            for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+        }
+        if (_dropped != 0) {
+            order.erase(std::remove_if(order.begin(), order.end(), [this](std::size_t k) {
+                return _bins[k].empty();
+            }), order.end());
+        }
+
+        detail::permute(_bins, order);
+        detail::permute(_cells, order);
+        detail::permute(_heads, order);
+        if (_ranked()) detail::permute(_seqs, order);
+        _arranged = true;
+        _dropped  = 0;
+
+        _table.clear();
+        for (std::size_t k = 0; k < _cells.size(); ++k)
+            _table.insert(_cells[k], static_cast<std::uint32_t>(k));
+    }
+
+    // Bin stays in `_bins` (empty) until next snapshot
+    void _drop(std::size_t slot) {
+        _bins[slot].clear();
+        if (_ranked()) _seqs[slot].clear();
+        _heads[slot] = 0;
+        _table.erase(_cells[slot]);
+        ++_dropped;
+    }
+
+    // Removes the oldest live point of bin in O(1) amortized
+    void _pop_front(std::size_t slot) {
+        const std::size_t head = ++_heads[slot];
+        if (head == _bins[slot].size()) {
+            _drop(slot);
+            return;
+        }
+
+        _arranged = _arranged && !_ranked(); // first live point of bin changed
+        if (2 * head >= _bins[slot].size()) {
+            _compact(slot);
+        } else {
+            _trimmed = true;
+        }
+    }
+
+public:
+
+    explicit HexbinAccumulator(const HexbinT& hexbin = HexbinT())
+        : _hexbin(hexbin)
+    {}
+
+    const HexbinT& hexbin() const {
+        return _hexbin;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Returns false, if point is skipped (NaN coordinate or out of extent,
+        if clip() is set).
+     */
+    bool add(const datum_t& point)
+    {
+        int pi, pj;
+        if (!_hexbin._cell(point, pi, pj)) return false;
+
+        const std::uint64_t cell = detail::pack_cell(pi, pj);
+        const auto found = _table.insert(cell, static_cast<std::uint32_t>(_bins.size()));
+        if (found.second) { // not found - new bin
+            _bins.emplace_back(point);
+            _hexbin._place(_bins.back(), pi, pj);
+            _cells.push_back(cell);
+            _heads.push_back(0);
+            if (_ranked()) _seqs.push_back({_seq});
+            _arranged = _arranged && _ranked();
+        } else {
+            _bins[found.first].push_back(point);
+            if (_ranked()) _seqs[found.first].push_back(_seq);
+        }
+        ++_seq;
+        return true;
+    }
+
+    template <typename Iterator>
+    void add(Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+            add(*first);
+    }
+
+    void add(const std::vector<datum_t>& points)
+    {
+        add(points.begin(), points.end());
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Removes the oldest point, equal to `point` (by `operator==`), from its
+        bin - the bin is found by the same quantization, as in add(). Returns
+        false, if there is no such point. O(1) amortized, if it is the oldest
+        point of bin (like in sliding windows), otherwise O(bin size).
+     */
+    bool remove(const datum_t& point)
+    {
+        int pi, pj;
+        if (!_hexbin._cell(point, pi, pj)) return false;
+
+        const std::uint32_t slot = _table.find( detail::pack_cell(pi, pj) );
+        if (slot == detail::no_slot) return false;
+
+        bin_t& bin = _bins[slot];
+        const auto head = bin.begin() + _heads[slot];
+        const auto it = std::find(head, bin.end(), point);
+        if (it == bin.end()) return false;
+
+        if (it == head) {
+            _pop_front(slot);
+        } else {
+            if (_ranked()) _seqs[slot].erase(_seqs[slot].begin() + (it - bin.begin()));
+            bin.erase(it);
+        }
+        return true;
+    }
+
+    /**
+        Removes the oldest point from bin with id `bin_id` (see ids()) in
+        O(1) amortized. Returns false, if there is no such bin.
+     */
+    bool decrement(std::uint64_t bin_id)
+    {
+        const std::uint32_t slot = _table.find(bin_id);
+        if (slot == detail::no_slot) return false;
+
+        _pop_front(slot);
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Returns current bins - the same as Hexbin::operator() of all live
+        (added & not removed) points. Bins are re-sorted only if new bins were
+        added since previous call (for `first_seen` order - only if the first
+        live point of some bin was removed). Returned reference is valid
+        until next modification.
+     */
+    const std::vector<bin_t>& snapshot()
+    {
+        if (_trimmed) {
+            for (std::size_t k = 0; k < _bins.size(); ++k)
+                if (_heads[k] != 0) _compact(k);
+            _trimmed = false;
+        }
+        _arrange();
+        return _bins;
+    }
+
+    /**
+        Returns ids of bins of snapshot() (packed (pi, pj) offset coordinates
+        of bins hexagons), same order.
+     */
+    const std::vector<std::uint64_t>& ids()
+    {
+        _arrange();
+        return _cells;
+    }
+
+    std::size_t size() const {
+        return _bins.size() - _dropped;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear()
+    {
+        _table.clear();
+        _bins.clear();
+        _cells.clear();
+        _heads.clear();
+        _seqs.clear();
+        _seq      = 0;
+        _arranged = true;
+        _trimmed  = false;
+        _dropped  = 0;
+    }
+};
+
+template <typename HexbinT>
+inline HexbinAccumulator<HexbinT> accumulator(const HexbinT& hexbin) {
+    return HexbinAccumulator<HexbinT>(hexbin);
+}
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__ACCUMULATOR_HPP
@@ -0,0 +1,252 @@
+#ifndef D3__HEXBIN__AGGREGATE_HPP
+#define D3__HEXBIN__AGGREGATE_HPP
+
+#include <cstddef>     // for std::size_t
+#include <limits>      // for std::numeric_limits<T>::...
+#include <algorithm>   // for std::min(), std::max()
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: per-bin aggregators for Hexbin::aggregate().
+
+    Aggregator is a compile-time policy, which describes fixed-size per-bin
+    state and 4 operations on it:
+
+    @code{.cpp}
+    struct Aggregator {
+        using state_t  = ...;
+        using result_t = ...;
+
+        state_t  init() const;                                  // empty bin state
+        template <typename T>
+        void     accumulate(state_t& state, const T& d) const;  // add datum into bin
+        void     merge(state_t& state, const state_t& other) const;
+        result_t finalize(const state_t& state) const;
+    };
+    @endcode
+
+    Value-based aggregators take value accessor (`NumberT (const T&)`
+    callable), like `bin.x()` / `bin.y()` accessors. Use factory functions
+    (`aggregate::sum()`, ...) to pass lambdas.
+ */
+namespace aggregate {
+
+namespace detail {
+
+template <typename NumberT>
+inline NumberT lowest() {
+    return std::numeric_limits<NumberT>::has_infinity ? -std::numeric_limits<NumberT>::infinity()
+                                                      :  std::numeric_limits<NumberT>::lowest();
+}
+
+template <typename NumberT>
+inline NumberT highest() {
+    return std::numeric_limits<NumberT>::has_infinity ?  std::numeric_limits<NumberT>::infinity()
+                                                      :  std::numeric_limits<NumberT>::max();
+}
+
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+
+struct Count
+{
+    using state_t  = std::size_t;
+    using result_t = std::size_t;
+
+    state_t init() const { return 0; }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& /*d*/) const { ++state; }
+
+    void merge(state_t& state, const state_t& other) const { state += other; }
+
+    result_t finalize(const state_t& state) const { return state; }
+};
+
+// -----------------------------------------------------------------------------
+
+template <typename ValueFunc, typename NumberT = double>
+struct Sum
+{
+    using state_t  = NumberT;
+    using result_t = NumberT;
+
+    ValueFunc value;
+
+    state_t init() const { return 0; }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& d) const { state += value(d); }
+
+    void merge(state_t& state, const state_t& other) const { state += other; }
+
+    result_t finalize(const state_t& state) const { return state; }
+};
+
+template <typename ValueFunc, typename NumberT = double>
+struct Min
+{
+    using state_t  = NumberT;
+    using result_t = NumberT;
+
+    ValueFunc value;
+
+    state_t init() const { return detail::highest<NumberT>(); }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& d) const { state = std::min<NumberT>(state, value(d)); }
+
+    void merge(state_t& state, const state_t& other) const { state = std::min(state, other); }
+
+    result_t finalize(const state_t& state) const { return state; }
+};
+
+template <typename ValueFunc, typename NumberT = double>
+struct Max
+{
+    using state_t  = NumberT;
+    using result_t = NumberT;
+
+    ValueFunc value;
+
+    state_t init() const { return detail::lowest<NumberT>(); }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& d) const { state = std::max<NumberT>(state, value(d)); }
+
+    void merge(state_t& state, const state_t& other) const { state = std::max(state, other); }
+
+    result_t finalize(const state_t& state) const { return state; }
+};
+
+template <typename ValueFunc, typename NumberT = double>
+struct Mean
+{
+    struct state_t {
+        std::size_t count;
+        NumberT     sum;
+    };
+    using result_t = NumberT;
+
+    ValueFunc value;
+
+    state_t init() const { return {0, 0}; }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& d) const { ++state.count; state.sum += value(d); }
+
+    void merge(state_t& state, const state_t& other) const { state.count += other.count; state.sum += other.sum; }
+
+    result_t finalize(const state_t& state) const { return state.sum / state.count; }
+};
+
+// -----------------------------------------------------------------------------
+
+template <typename NumberT>
+struct Summary
+{
+    std::size_t count;
+    NumberT     sum;
+    NumberT     mean;
+    NumberT     min;
+    NumberT     max;
+
+    /// Sample variance (same as in d3.variance()), NaN if count < 2
+    NumberT     variance;
+};
+
+/**
+    Count, sum, mean, min, max & variance in one pass. Mean & variance are
+    updated by Welford's algorithm, states are merged by Chan's formula.
+ */
+template <typename ValueFunc, typename NumberT = double>
+struct Stats
+{
+    struct state_t {
+        std::size_t count;
+        NumberT     sum;
+        NumberT     mean;
+        NumberT     m2;
+        NumberT     min;
+        NumberT     max;
+    };
+    using result_t = Summary<NumberT>;
+
+    ValueFunc value;
+
+    state_t init() const {
+        return {0, 0, 0, 0, detail::highest<NumberT>(), detail::lowest<NumberT>()};
+    }
+
+    template <typename T>
+    void accumulate(state_t& state, const T& d) const {
+        const NumberT v = value(d);
+        const NumberT delta = v - state.mean;
+        ++state.count;
+        state.sum  += v;
+        state.mean += delta / state.count;
+        state.m2   += delta * (v - state.mean);
+        state.min   = std::min(state.min, v);
+        state.max   = std::max(state.max, v);
+    }
+
+    void merge(state_t& state, const state_t& other) const {
+        if (other.count == 0) return;
+        if (state.count == 0) { state = other; return; }
+
+        const std::size_t count = state.count + other.count;
+        const NumberT delta = other.mean - state.mean;
+        state.mean += delta * other.count / count;
+        state.m2   += other.m2 + delta * delta * state.count * other.count / count;
+        state.sum  += other.sum;
+        state.min   = std::min(state.min, other.min);
+        state.max   = std::max(state.max, other.max);
+        state.count = count;
+    }
+
+    result_t finalize(const state_t& state) const {
+        const NumberT variance = (state.count > 1) ? state.m2 / (state.count - 1)
+                                                   : std::numeric_limits<NumberT>::quiet_NaN();
+        return {state.count, state.sum, state.mean, state.min, state.max, variance};
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Factories
+
+inline Count count() {
+    return Count{};
+}
+
+template <typename NumberT = double, typename ValueFunc>
+inline Sum<ValueFunc, NumberT> sum(const ValueFunc& value) {
+    return Sum<ValueFunc, NumberT>{value};
+}
+
+template <typename NumberT = double, typename ValueFunc>
+inline Min<ValueFunc, NumberT> min(const ValueFunc& value) {
+    return Min<ValueFunc, NumberT>{value};
+}
+
+template <typename NumberT = double, typename ValueFunc>
+inline Max<ValueFunc, NumberT> max(const ValueFunc& value) {
+    return Max<ValueFunc, NumberT>{value};
+}
+
+template <typename NumberT = double, typename ValueFunc>
+inline Mean<ValueFunc, NumberT> mean(const ValueFunc& value) {
+    return Mean<ValueFunc, NumberT>{value};
+}
+
+template <typename NumberT = double, typename ValueFunc>
+inline Stats<ValueFunc, NumberT> stats(const ValueFunc& value) {
+    return Stats<ValueFunc, NumberT>{value};
+}
+
+} // namespace aggregate
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__AGGREGATE_HPP
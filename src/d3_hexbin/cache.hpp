@@ -0,0 +1,226 @@
+#ifndef D3__HEXBIN__CACHE_HPP
+#define D3__HEXBIN__CACHE_HPP
+
+#include "hexbin.hpp"
+
+#include <list>          // for std::list<T>
+#include <unordered_map> // for std::unordered_map<K, V>
+#include <memory>        // for std::shared_ptr<T>
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: opt-in memoization of Hexbin::operator() & Hexbin::counts()
+    results. Result is selected by caller-supplied dataset `version` token
+    and hexbin configuration: radius, order(), clip() & extent - only if
+    clip() is set (otherwise extent & engine() don't affect results, so
+    panning & zooming of unclipped viewport hits cache). Accessors are not
+    compared - they are part of dataset identity, so use other version token
+    for other accessors.
+
+    Results are kept in LRU order under `budget` bytes (size of result is
+    estimated by its vectors capacities, heap memory owned by `T` is not
+    counted). Result, larger than budget, is returned, but not cached.
+
+    @code{.cpp}
+    d3_hexbin::HexbinCache<decltype(hexbin)> cache(64 << 20); // 64 MiB
+    const auto bins = cache.bins(hexbin.radius(r), points, points_version); // std::shared_ptr<const std::vector<bin_t>>
+    // cache.hits(), cache.misses(), cache.evictions(), cache.bytes()
+    @endcode
+ */
+template <typename HexbinT>
+class HexbinCache
+{
+public:
+
+    using hexbin_t   = HexbinT;
+    using datum_t    = typename HexbinT::datum_t;
+    using bin_t      = typename HexbinT::bin_t;
+    using number_t   = typename bin_t::number_t;
+    using count_t    = HexbinCount<number_t>;
+    using bins_ptr   = std::shared_ptr<const std::vector<bin_t>>;
+    using counts_ptr = std::shared_ptr<const std::vector<count_t>>;
+
+private:
+    enum class _Kind { bins, counts };
+
+    struct _Key
+    {
+        std::uint64_t version;
+        _Kind         kind;
+        number_t      r, x0, y0, x1, y1;
+        HexbinOrder   order;
+        bool          clip;
+
+        bool operator == (const _Key& other) const {
+            return version == other.version && kind == other.kind
+                && r  == other.r  && x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1
+                && order == other.order && clip == other.clip;
+        }
+    };
+
+    struct _KeyHash
+    {
+        std::size_t operator () (const _Key& key) const {
+            std::size_t h = std::hash<std::uint64_t>()(key.version);
+            const auto mix = [&h](std::size_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+            mix(static_cast<std::size_t>(key.kind));
+            mix(std::hash<number_t>()(key.r));
+            mix(std::hash<number_t>()(key.x0));
+            mix(std::hash<number_t>()(key.y0));
+            mix(std::hash<number_t>()(key.x1));
+            mix(std::hash<number_t>()(key.y1));
+            mix(static_cast<std::size_t>(key.order));
+            mix(key.clip);
+            return h;
+        }
+    };
+
+    struct _Entry
+    {
+        _Key        key;
+        bins_ptr    bins;   // set for _Kind::bins
+        counts_ptr  counts; // set for _Kind::counts
+        std::size_t bytes;
+    };
+
+    using _list_t = std::list<_Entry>;
+
+    std::size_t _budget;
+    std::size_t _bytes = 0;
+
+    _list_t                                                       _lru; // most recently used first
+    std::unordered_map<_Key, typename _list_t::iterator, _KeyHash> _index;
+
+    std::size_t _hits      = 0;
+    std::size_t _misses    = 0;
+    std::size_t _evictions = 0;
+
+    // Extent is part of key only if clip() is set (it is zero otherwise)
+    static _Key _key(const HexbinT& hexbin, std::uint64_t version, _Kind kind) {
+        if (!hexbin._clip)
+            return {version, kind, hexbin.r, 0, 0, 0, 0, hexbin._order, false};
+        return {version, kind, hexbin.r, hexbin.x0, hexbin.y0, hexbin.x1, hexbin.y1, hexbin._order, true};
+    }
+
+    static std::size_t _size(const std::vector<bin_t>& bins) {
+        std::size_t bytes = sizeof(bins) + bins.capacity() * sizeof(bin_t);
+        for (const bin_t& bin : bins)
+            bytes += bin.capacity() * sizeof(datum_t);
+        return bytes;
+    }
+
+    static std::size_t _size(const std::vector<count_t>& counts) {
+        return sizeof(counts) + counts.capacity() * sizeof(count_t);
+    }
+
+    // Returns cached entry (and marks it as most recently used), or nullptr
+    const _Entry* _find(const _Key& key) {
+        const auto found = _index.find(key);
+        if (found == _index.end()) {
+            ++_misses;
+            return nullptr;
+        }
+        ++_hits;
+        _lru.splice(_lru.begin(), _lru, found->second);
+        return &*found->second;
+    }
+
+    void _insert(_Entry&& entry) {
+        if (entry.bytes > _budget) return;
+
+        _bytes += entry.bytes;
+        _lru.push_front(std::move(entry));
+        _index[_lru.front().key] = _lru.begin();
+
+        while (_bytes > _budget) {
+            _bytes -= _lru.back().bytes;
+            _index.erase(_lru.back().key);
+            _lru.pop_back();
+            ++_evictions;
+        }
+    }
+
+public:
+
+    explicit HexbinCache(std::size_t budget)
+        : _budget(budget)
+    {}
+
+    // -------------------------------------------------------------------------
+
+    /// Returns (cached) result of `hexbin(points)`
+    bins_ptr bins(const HexbinT& hexbin, const std::vector<datum_t>& points, std::uint64_t version)
+    {
+        const _Key key = _key(hexbin, version, _Kind::bins);
+        if (const _Entry* entry = _find(key)) return entry->bins;
+
+        const bins_ptr bins = std::make_shared<const std::vector<bin_t>>( hexbin(points) );
+        _insert(_Entry{key, bins, nullptr, _size(*bins)});
+        return bins;
+    }
+
+    /// Returns (cached) result of `hexbin.counts(points)`
+    counts_ptr counts(const HexbinT& hexbin, const std::vector<datum_t>& points, std::uint64_t version)
+    {
+        const _Key key = _key(hexbin, version, _Kind::counts);
+        if (const _Entry* entry = _find(key)) return entry->counts;
+
+        const counts_ptr counts = std::make_shared<const std::vector<count_t>>( hexbin.counts(points) );
+        _insert(_Entry{key, nullptr, counts, _size(*counts)});
+        return counts;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /// Removes all results of dataset `version`
+    void invalidate(std::uint64_t version)
+    {
+        for (auto it = _lru.begin(); it != _lru.end(); ) {
+            if (it->key.version == version) {
+                _bytes -= it->bytes;
+                _index.erase(it->key);
+                it = _lru.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear()
+    {
+        _lru.clear();
+        _index.clear();
+        _bytes = 0;
+    }
+
+    /// Returns cached results count
+    std::size_t size() const {
+        return _lru.size();
+    }
+
+    /// Returns estimated size of cached results
+    std::size_t bytes() const {
+        return _bytes;
+    }
+
+    std::size_t budget() const {
+        return _budget;
+    }
+
+    std::size_t hits() const {
+        return _hits;
+    }
+
+    std::size_t misses() const {
+        return _misses;
+    }
+
+    std::size_t evictions() const {
+        return _evictions;
+    }
+};
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__CACHE_HPP
@@ -0,0 +1,290 @@
+#ifndef D3__HEXBIN__CSV_HPP
+#define D3__HEXBIN__CSV_HPP
+
+#include "hexbin.hpp"
+
+#include <istream> // for std::istream
+#include <cstdlib> // for std::strtod()
+#include <cstring> // for std::memcpy()
+
+#if (__cplusplus >= 201703L) && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv> // for std::from_chars()
+#endif
+#endif
+
+namespace d3_hexbin {
+
+namespace detail {
+
+/**
+    Parses whole [first, last) as number (leading & trailing spaces are
+    allowed). Uses std::from_chars(), if floating-point overloads are
+    available, otherwise std::strtod() (locale-dependent).
+ */
+template <typename number_t>
+inline bool parse_number(const char* first, const char* last, number_t& value)
+{
+    while (first != last && (*first == ' ' || *first == '\t')) ++first;
+    while (first != last && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+    // '+' is accepted by strtod(), but not by from_chars() - skipped only if followed by digits
+    if (last - first > 1 && *first == '+' && ((first[1] >= '0' && first[1] <= '9') || first[1] == '.')) ++first;
+    if (first == last) return false;
+
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+    const std::from_chars_result result = std::from_chars(first, last, value);
+    return (result.ec == std::errc() && result.ptr == last);
+#else
+    char buffer[64];
+    const std::size_t length = static_cast<std::size_t>(last - first);
+    if (length >= sizeof(buffer)) return false;
+    std::memcpy(buffer, first, length);
+    buffer[length] = '\0';
+
+    char* end = nullptr;
+    value = static_cast<number_t>(std::strtod(buffer, &end));
+    return (end == buffer + length);
+#endif
+}
+
+} // namespace detail
+
+/**
+    Non-standart: streaming CSV ingestion. Text is consumed by chunks of any
+    size (lines may span chunks), x & y values are taken from configured
+    columns and binned by blocks (with SIMD quantization, see quantize.hpp)
+    directly into bins counts - points are never stored, so memory usage is
+    O(bins + chunk).
+
+    Uses radius, extent, clip() & order() of specified hexbin (copied on
+    construction), accessors are not used. Rows with missing or unparsable
+    x / y are skipped (counted by skipped()). Quoted fields are not
+    supported.
+
+    @code{.cpp}
+    d3_hexbin::HexbinCsv<decltype(hexbin)> csv(hexbin, 1, 2); // x - column 1, y - column 2
+    std::ifstream file("points.csv", std::ios::binary);
+    csv.read(file);
+    const auto& counts = csv.counts(); // same as hexbin.counts() of parsed points
+    @endcode
+ */
+template <typename HexbinT>
+class HexbinCsv
+{
+public:
+
+    using hexbin_t = HexbinT;
+    using number_t = typename HexbinT::bin_t::number_t;
+    using count_t  = HexbinCount<number_t>;
+
+private:
+    HexbinT     _hexbin;
+    std::size_t _x_column;
+    std::size_t _y_column;
+    char        _delimiter;
+    bool        _header;
+    std::size_t _chunk;
+
+    std::string _carry;         // incomplete line from previous chunk
+    std::size_t _rows    = 0;   // data rows (w/o header)
+    std::size_t _skipped = 0;
+
+    number_t    _xs[detail::block_size];
+    number_t    _ys[detail::block_size];
+    std::size_t _pending = 0;   // parsed points in block
+
+    detail::CellTable          _table;
+    std::vector<count_t>       _counts;
+    std::vector<std::uint64_t> _cells; // slot -> cell
+    bool                       _arranged = true;
+
+    void _flush()
+    {
+        if (_pending == 0) return;
+
+        int pi[detail::block_size], pj[detail::block_size];
+        if (_hexbin._clip) _hexbin._clip_block(_xs, _ys, _pending);
+        _hexbin.quantize(_xs, _ys, _pending, pi, pj);
+
+        for (std::size_t k = 0; k < _pending; ++k) {
+            if (pi[k] == detail::invalid_cell) continue;
+
+            const std::uint64_t cell = detail::pack_cell(pi[k], pj[k]);
+            const auto found = _table.insert(cell, static_cast<std::uint32_t>(_counts.size()));
+            if (found.second) {
+                _counts.push_back({_hexbin._center_x(pi[k], pj[k]), _hexbin._center_y(pj[k]), 1});
+                _cells.push_back(cell);
+                _arranged = _arranged && (_hexbin._order == HexbinOrder::first_seen);
+            } else {
+                ++_counts[found.first].count;
+            }
+        }
+        _pending = 0;
+    }
+
+    void _line(const char* first, const char* last)
+    {
+        if (_header) { // skip header line
+            _header = false;
+            return;
+        }
+        if (first == last || (last - first == 1 && *first == '\r')) return; // empty line
+
+        ++_rows;
+
+        const char* fx = nullptr, *lx = nullptr, *fy = nullptr, *ly = nullptr;
+        std::size_t column = 0;
+        for (const char* field = first; ; ++column) {
+            const char* end = std::find(field, last, _delimiter);
+            if (column == _x_column) { fx = field; lx = end; }
+            if (column == _y_column) { fy = field; ly = end; }
+            if (end == last || (fx && fy)) break;
+            field = end + 1;
+        }
+
+        number_t px, py;
+        if (!fx || !fy || !detail::parse_number(fx, lx, px) || !detail::parse_number(fy, ly, py)) {
+            ++_skipped;
+            return;
+        }
+
+        _xs[_pending] = px;
+        _ys[_pending] = py;
+        if (++_pending == detail::block_size) _flush();
+    }
+
+    void _arrange()
+    {
+        if (_arranged) return;
+        _arranged = true;
+
+        const std::vector<std::size_t> order = _hexbin._ordering(_cells);
+        detail::permute(_counts, order);
+        detail::permute(_cells, order);
+
+        _table.clear();
+        for (std::size_t k = 0; k < _cells.size(); ++k)
+            _table.insert(_cells[k], static_cast<std::uint32_t>(k));
+    }
+
+public:
+
+    /**
+        `x_column` & `y_column` are zero-based columns indices. If `header`
+        is set, first line is skipped. `chunk` is buffer size of read().
+     */
+    HexbinCsv(const HexbinT& hexbin, std::size_t x_column, std::size_t y_column,
+              char delimiter = ',', bool header = true, std::size_t chunk = 1 << 16)
+        : _hexbin(hexbin)
+        , _x_column(x_column)
+        , _y_column(y_column)
+        , _delimiter(delimiter)
+        , _header(header)
+        , _chunk(chunk > 0 ? chunk : 1)
+    {}
+
+    const HexbinT& hexbin() const {
+        return _hexbin;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Consumes next chunk of text. Incomplete last line is kept until next
+        chunk or finish().
+     */
+    void feed(const char* data, std::size_t size)
+    {
+        const char* end = data + size;
+        const char* eol = std::find(data, end, '\n');
+        if (eol == end) {
+            _carry.append(data, size);
+            return;
+        }
+
+        if (!_carry.empty()) {
+            _carry.append(data, eol);
+            _line(_carry.data(), _carry.data() + _carry.size());
+            _carry.clear();
+        } else {
+            _line(data, eol);
+        }
+
+        for (data = eol + 1; (eol = std::find(data, end, '\n')) != end; data = eol + 1)
+            _line(data, eol);
+
+        _carry.assign(data, end);
+    }
+
+    /// Processes last line (if text doesn't end with newline) & pending points
+    void finish()
+    {
+        if (!_carry.empty()) {
+            _line(_carry.data(), _carry.data() + _carry.size());
+            _carry.clear();
+        }
+        _flush();
+    }
+
+    /**
+        Reads whole stream by chunks, then calls finish(). Returns false on
+        read error.
+     */
+    bool read(std::istream& in)
+    {
+        std::vector<char> buffer(_chunk);
+        while (in) {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            feed(buffer.data(), static_cast<std::size_t>(in.gcount()));
+        }
+        finish();
+        return in.eof() && !in.bad();
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Returns bins counts - the same as Hexbin::counts() of points of all
+        finished rows. Returned reference is valid until next modification.
+     */
+    const std::vector<count_t>& counts()
+    {
+        _flush();
+        _arrange();
+        return _counts;
+    }
+
+    /// Returns data rows count (without header & empty lines)
+    std::size_t rows() const {
+        return _rows;
+    }
+
+    /// Returns count of rows with missing or unparsable x / y
+    std::size_t skipped() const {
+        return _skipped;
+    }
+
+    void clear(bool header = true)
+    {
+        _header  = header;
+        _carry.clear();
+        _rows    = 0;
+        _skipped = 0;
+        _pending = 0;
+
+        _table.clear();
+        _counts.clear();
+        _cells.clear();
+        _arranged = true;
+    }
+};
+
+template <typename HexbinT>
+inline HexbinCsv<HexbinT> csv(const HexbinT& hexbin, std::size_t x_column, std::size_t y_column,
+                              char delimiter = ',', bool header = true) {
+    return HexbinCsv<HexbinT>(hexbin, x_column, y_column, delimiter, header);
+}
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__CSV_HPP
@@ -5,7 +5,12 @@
 
 #include <array>      // for std::array<T, N>
 #include <vector>     // for std::vector<T>
-#include <map>        // for std::map<K,V>
+#include <memory>     // for std::allocator<T>, std::allocator_traits<A>
+#include <utility>    // for std::pair<A,B>, std::move()
+#include <algorithm>  // for std::sort(), std::fill()
+#include <cstdint>    // for std::uint64_t, std::uint32_t
+#include <thread>     // for std::thread
+#include <atomic>     // for std::atomic<T>
 
 #include <functional> // for std::function<R(T)>
 #include <string>     // for std::string
@@ -16,6 +21,16 @@
 #include <type_traits> // for std::enable_if()
 #include <limits>      // for std::numeric_limits<T>::...
 
+#if (__cplusplus >= 201703L) && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource> // for std::pmr::polymorphic_allocator<T>
+#define D3_HEXBIN_HAS_PMR 1
+#endif
+#endif
+
+#include "aggregate.hpp"
+#include "quantize.hpp"
+
 namespace d3_hexbin {
 
 namespace detail {
@@ -72,211 +87,2088 @@ struct has_subscript< T, Index, void_t< subscript_t<T,Index> > > : std::true_typ
     inline NumberT pointX(const T& d) { return d[0]; }
     @endcode
 
-    But this not enough, to implement original js behavior: if type NOT contains
-    '[] operator', return null/undefined/NaN. That's why below implemented
-    HUGE & COMPLICATED overloaded functions (pointX() and PointY() ), which
-    determines in compile-time - is type contains 'subscript operator' - then
-    uses it, otherwise (if not) returns NaN.
- */
+    But this not enough, to implement original js behavior: if type NOT contains
+    '[] operator', return null/undefined/NaN. That's why below implemented
+    HUGE & COMPLICATED overloaded functions (pointX() and PointY() ), which
+    determines in compile-time - is type contains 'subscript operator' - then
+    uses it, otherwise (if not) returns NaN.
+ */
+
+template <typename DatumT, typename NumberT>
+inline
+    typename std::enable_if< detect::has_subscript<DatumT>::value == false, NumberT >::type
+pointX(const DatumT& /*d*/) {
+    static_assert(std::numeric_limits<NumberT>::has_quiet_NaN == true, "NumberT doesn't have NaN support");
+    return std::numeric_limits<NumberT>::quiet_NaN();
+}
+
+template <typename DatumT, typename NumberT>
+inline
+    typename std::enable_if< detect::has_subscript<DatumT>::value == true, NumberT >::type
+pointX(const DatumT& d) {
+    return d[0];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+template <typename DatumT, typename NumberT>
+inline
+    typename std::enable_if< detect::has_subscript<DatumT>::value == false, NumberT >::type
+pointY(const DatumT& /*d*/) {
+    static_assert(std::numeric_limits<NumberT>::has_quiet_NaN == true, "NumberT doesn't have NaN support");
+    return std::numeric_limits<NumberT>::quiet_NaN();
+}
+
+template <typename DatumT, typename NumberT>
+inline
+    typename std::enable_if< detect::has_subscript<DatumT>::value == true, NumberT >::type
+pointY(const DatumT& d) {
+    return d[1];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+/**
+    Default accessor policies for Hexbin (same as pointX() & pointY(), but as
+    function objects, which may be inlined into binning loop).
+ */
+
+template <typename DatumT, typename NumberT>
+struct PointX {
+    NumberT operator () (const DatumT& d) const { return pointX<DatumT, NumberT>(d); }
+};
+
+template <typename DatumT, typename NumberT>
+struct PointY {
+    NumberT operator () (const DatumT& d) const { return pointY<DatumT, NumberT>(d); }
+};
+
+// -----------------------------------------------------------------------------
+// Cell keys
+
+/**
+    Packs hexagon offset coordinates (pi, pj) into single 64-bit key:
+    `pj` goes into high 32 bits, `pi` into low 32 bits.
+ */
+inline std::uint64_t pack_cell(int i, int j) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(j)) << 32)
+         |  static_cast<std::uint64_t>(static_cast<std::uint32_t>(i));
+}
+
+inline int cell_i(std::uint64_t key) {
+    return static_cast<int>(static_cast<std::uint32_t>(key));
+}
+
+inline int cell_j(std::uint64_t key) {
+    return static_cast<int>(static_cast<std::uint32_t>(key >> 32));
+}
+
+/// Key of skipped (NaN or clipped) point: pack_cell(invalid_cell, invalid_cell)
+constexpr std::uint64_t no_cell = 0x8000000080000000ULL;
+
+// -----------------------------------------------------------------------------
+// Open-addressing hash table (cell key -> bin slot)
+
+/// Points are loaded & quantized by blocks of this size
+constexpr std::size_t block_size = 256;
+
+constexpr std::uint32_t no_slot = 0xFFFFFFFF;
+
+/**
+    Minimal linear-probing hash table, which maps packed cell keys into bin
+    slots (indices in output bins vector). Used instead of original
+    `std::map<std::string, bin_t>` - no string formatting & no tree nodes per
+    bin. `clear()` keeps allocated capacity.
+ */
+class CellTable
+{
+    struct Entry {
+        std::uint64_t key;
+        std::uint32_t slot;
+    };
+
+    std::vector<Entry> _entries;
+    std::size_t        _size = 0;
+
+    static std::size_t _hash(std::uint64_t key) {
+        // splitmix64 finalizer
+        key ^= key >> 30; key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27; key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return static_cast<std::size_t>(key);
+    }
+
+    void _rehash(std::size_t capacity) {
+        std::vector<Entry> old(capacity, Entry{0, no_slot});
+        old.swap(_entries);
+
+        const std::size_t mask = _entries.size() - 1;
+        for(const Entry& e : old) {
+            if (e.slot == no_slot) continue;
+            std::size_t pos = _hash(e.key) & mask;
+            while (_entries[pos].slot != no_slot) pos = (pos + 1) & mask;
+            _entries[pos] = e;
+        }
+    }
+
+public:
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    void reserve(std::size_t count) {
+        std::size_t capacity = 16;
+        while (capacity * 3 < count * 4) capacity *= 2; // load factor <= 0.75
+        if (capacity > _entries.size()) _rehash(capacity);
+    }
+
+    void clear() {
+        std::fill(_entries.begin(), _entries.end(), Entry{0, no_slot});
+        _size = 0;
+    }
+
+    std::uint32_t find(std::uint64_t key) const {
+        if (_entries.empty()) return no_slot;
+        const std::size_t mask = _entries.size() - 1;
+        for (std::size_t pos = _hash(key) & mask; ; pos = (pos + 1) & mask) {
+            const Entry& e = _entries[pos];
+            if (e.slot == no_slot || e.key == key) return e.slot;
+        }
+    }
+
+    /**
+        Returns {slot, true} if `key` was inserted with specified `slot`, or
+        {existing slot, false} if `key` already present.
+     */
+    std::pair<std::uint32_t, bool> insert(std::uint64_t key, std::uint32_t slot) {
+        if ((_size + 1) * 4 > _entries.size() * 3) reserve(_size + 1);
+
+        const std::size_t mask = _entries.size() - 1;
+        for (std::size_t pos = _hash(key) & mask; ; pos = (pos + 1) & mask) {
+            Entry& e = _entries[pos];
+            if (e.slot == no_slot) {
+                e.key = key; e.slot = slot; ++_size;
+                return {slot, true};
+            }
+            if (e.key == key) return {e.slot, false};
+        }
+    }
+
+    std::pair<std::uint32_t, bool> insert(int i, int j, std::uint32_t slot) {
+        return insert(pack_cell(i, j), slot);
+    }
+
+    /**
+        Removes `key` (backward-shift deletion, no tombstones). Returns false
+        if `key` not present.
+     */
+    bool erase(std::uint64_t key) {
+        if (_entries.empty()) return false;
+        const std::size_t mask = _entries.size() - 1;
+
+        std::size_t pos = _hash(key) & mask;
+        for (; _entries[pos].key != key || _entries[pos].slot == no_slot; pos = (pos + 1) & mask)
+            if (_entries[pos].slot == no_slot) return false;
+
+        for (std::size_t next = (pos + 1) & mask; _entries[next].slot != no_slot; next = (next + 1) & mask) {
+            const std::size_t ideal = _hash(_entries[next].key) & mask;
+            // entry at `next` may be moved into the hole, if its ideal position is not in (pos, next]
+            const bool stays = (pos <= next) ? (pos < ideal && ideal <= next)
+                                             : (pos < ideal || ideal <= next);
+            if (!stays) {
+                _entries[pos] = _entries[next];
+                pos = next;
+            }
+        }
+        _entries[pos].slot = no_slot;
+        --_size;
+        return true;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Dense grid (cell -> bin slot)
+
+constexpr std::size_t max_dense_cells = std::size_t(1) << 24;
+
+/// Dense grid is used only if it has at most this many cells per point (but
+/// at least `min_dense_cells`) - otherwise its filling costs more, than hash
+/// table lookups
+constexpr std::size_t dense_cells_per_point = 8;
+constexpr std::size_t min_dense_cells = std::size_t(1) << 16;
+
+/**
+    Flat row-major array of bin slots, indexed by `(j - j0) * cols + (i - i0)`,
+    for cells range known ahead of time (from extent). Cells out of range
+    are looked up in fallback hash table.
+ */
+class CellGrid
+{
+    std::int64_t _i0 = 0;
+    std::int64_t _j0 = 0;
+    std::size_t  _cols = 0;
+    std::size_t  _rows = 0;
+    std::vector<std::uint32_t> _slots;
+    CellTable _outside;
+
+public:
+
+    /**
+        Returns false (and leaves grid empty) if range [i0, i1] x [j0, j1]
+        contains more than `max_cells` cells (at most `max_dense_cells`).
+     */
+    bool reset(std::int64_t i0, std::int64_t j0, std::int64_t i1, std::int64_t j1,
+               std::size_t max_cells = max_dense_cells) {
+        _slots.clear();
+        _outside.clear();
+        _cols = _rows = 0;
+        if (i1 < i0 || j1 < j0) return false;
+
+        const std::uint64_t cols = i1 - i0 + 1, rows = j1 - j0 + 1;
+        max_cells = std::min(max_cells, max_dense_cells);
+        if (cols > max_cells || rows > max_cells / cols) return false;
+
+        _i0 = i0; _j0 = j0; _cols = cols; _rows = rows;
+        _slots.assign(_cols * _rows, no_slot);
+        return true;
+    }
+
+    std::pair<std::uint32_t, bool> insert(int i, int j, std::uint32_t slot) {
+        const std::uint64_t ci = static_cast<std::uint64_t>(i - _i0);
+        const std::uint64_t cj = static_cast<std::uint64_t>(j - _j0);
+        if (ci < _cols && cj < _rows) {
+            std::uint32_t& s = _slots[cj * _cols + ci];
+            if (s == no_slot) { s = slot; return {slot, true}; }
+            return {s, false};
+        }
+        return _outside.insert(i, j, slot);
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Threads
+
+inline unsigned resolve_threads(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : threads;
+}
+
+/**
+    Calls `func(i)` for each i in [0, count) on up to `threads` threads
+    (including calling thread).
+ */
+template <typename Func>
+inline void parallel_for(std::size_t count, unsigned threads, const Func& func) {
+    if (threads <= 1 || count <= 1) {
+        for (std::size_t i = 0; i < count; ++i) func(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next(0);
+    const auto worker = [&next, count, &func]() {
+        for (std::size_t i = next++; i < count; i = next++) func(i);
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min<std::size_t>(threads, count); ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& thread : pool) thread.join();
+}
+
+// -----------------------------------------------------------------------------
+// Bins ordering
+
+/**
+    Returns slots order, same as iteration order of `std::map<std::string, ...>`
+    with "pi-pj" string ids, which was used in original implementation.
+    Strings are built once per bin (not per point), and small enough for SSO.
+ */
+inline void order_by_id(const std::vector<std::uint64_t>& keys, std::vector<std::size_t>& order, std::vector<std::string>& ids) {
+    ids.resize(keys.size());
+    for(std::size_t i = 0; i < keys.size(); ++i)
+        ids[i] = std::to_string(cell_i(keys[i])) + "-" + std::to_string(cell_j(keys[i]));
+
+    order.resize(keys.size());
+    for(std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&ids](std::size_t a, std::size_t b) {
+        return ids[a] < ids[b];
+    });
+}
+
+inline std::vector<std::size_t> order_by_id(const std::vector<std::uint64_t>& keys) {
+    std::vector<std::size_t> order;
+    std::vector<std::string> ids;
+    order_by_id(keys, order, ids);
+    return order;
+}
+
+/**
+    Returns slots order, sorted by cells rows, then columns: (pj, pi).
+ */
+inline void order_by_cell(const std::vector<std::uint64_t>& keys, std::vector<std::size_t>& order) {
+    order.resize(keys.size());
+    for(std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) {
+        const int ja = cell_j(keys[a]), jb = cell_j(keys[b]);
+        return (ja != jb) ? (ja < jb) : (cell_i(keys[a]) < cell_i(keys[b]));
+    });
+}
+
+inline std::vector<std::size_t> order_by_cell(const std::vector<std::uint64_t>& keys) {
+    std::vector<std::size_t> order;
+    order_by_cell(keys, order);
+    return order;
+}
+
+/**
+    Reorders `items`, so that `items[k]` becomes `old items[order[k]]`.
+ */
+template <typename VectorT>
+inline void permute(VectorT& items, const std::vector<std::size_t>& order) {
+    VectorT result(items.get_allocator());
+    result.reserve(order.size());
+    for(const std::size_t i : order)
+        result.push_back( std::move(items[i]) );
+    items.swap(result);
+}
+
+// -----------------------------------------------------------------------------
+// Radix sort
+
+/**
+    Packs (pi, pj) into key, which unsigned order is (pj, pi) order (sign
+    bits are flipped).
+ */
+inline std::uint64_t pack_sortable_cell(int i, int j) {
+    return pack_cell(i, j) ^ 0x8000000080000000ULL;
+}
+
+inline std::uint64_t sortable_to_cell(std::uint64_t key) {
+    return key ^ 0x8000000080000000ULL;
+}
+
+/**
+    Stable LSD radix sort of (key, value) pairs by key, 8 bits per pass.
+    Passes, where all keys have the same digit, are skipped (so usually only
+    4 or less passes are made for cells keys).
+ */
+template <typename ValueT>
+inline void radix_sort(std::vector<std::uint64_t>& keys, std::vector<ValueT>& values) {
+    const std::size_t n = keys.size();
+    std::vector<std::uint64_t> keys_tmp(n);
+    std::vector<ValueT>        values_tmp(n);
+
+    std::size_t histograms[8][256] = {};
+    for (const std::uint64_t key : keys)
+        for (unsigned pass = 0; pass < 8; ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xFF];
+
+    for (unsigned pass = 0; pass < 8; ++pass) {
+        std::size_t* counts = histograms[pass];
+        const unsigned shift = pass * 8;
+        if (n == 0 || counts[(keys[0] >> shift) & 0xFF] == n) continue; // same digit
+
+        std::size_t offset = 0;
+        for (unsigned d = 0; d < 256; ++d) {
+            const std::size_t count = counts[d];
+            counts[d] = offset;
+            offset += count;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::size_t pos = counts[(keys[i] >> shift) & 0xFF]++;
+            keys_tmp[pos]   = keys[i];
+            values_tmp[pos] = values[i];
+        }
+        keys.swap(keys_tmp);
+        values.swap(values_tmp);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+} // namespace detail
+
+template <typename T, typename NumberT>
+class HexbinWorkspace;
+
+// Based on: https://github.com/DefinitelyTyped/DefinitelyTyped/blob/master/types/d3-hexbin/index.d.ts#L11
+
+/**
+ * Non-standart: points of bin are allocated by `Allocator` (see allocator
+ * overload of Hexbin::operator()).
+ */
+template <typename T, typename NumberT, typename Allocator = std::allocator<T> >
+struct HexbinBin : public std::vector<T, Allocator>
+{
+    using number_t = NumberT;
+
+    /**
+     * The x-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t x;
+
+    /**
+     * The y-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t y;
+
+    /**
+     * Non-standart: offset coordinates (column & row) of the associated
+     * bin’s hexagon (see Hexbin::cell_of() & Hexbin::center_of()).
+     */
+    int i;
+    int j;
+
+    // NOTICE: not via std::initializer_list, which makes extra copy of `d`
+    HexbinBin(const T& d, const Allocator& alloc = Allocator())
+        : std::vector<T, Allocator>(alloc)
+        , x(0)
+        , y(0)
+        , i(0)
+        , j(0)
+    {
+        this->push_back(d);
+    }
+
+    HexbinBin(T&& d, const Allocator& alloc = Allocator())
+        : std::vector<T, Allocator>(alloc)
+        , x(0)
+        , y(0)
+        , i(0)
+        , j(0)
+    {
+        this->push_back(std::move(d));
+    }
+
+    HexbinBin(const HexbinBin& other) = default;
+    HexbinBin(HexbinBin&& other) = default;
+    HexbinBin& operator = (const HexbinBin& other) = default;
+    HexbinBin& operator = (HexbinBin&& other) = default;
+
+    // Allocator-extended constructors (for containers with uses-allocator
+    // construction, like std::pmr::vector)
+
+    HexbinBin(const HexbinBin& other, const Allocator& alloc)
+        : std::vector<T, Allocator>(other, alloc)
+        , x(other.x)
+        , y(other.y)
+        , i(other.i)
+        , j(other.j)
+    {}
+
+    HexbinBin(HexbinBin&& other, const Allocator& alloc)
+        : std::vector<T, Allocator>(std::move(other), alloc)
+        , x(other.x)
+        , y(other.y)
+        , i(other.i)
+        , j(other.j)
+    {}
+
+private:
+    template <typename, typename>
+    friend class HexbinWorkspace;
+
+    // Empty bin (kept by HexbinWorkspace for reuse)
+    explicit HexbinBin(const Allocator& alloc)
+        : std::vector<T, Allocator>(alloc)
+        , x(0)
+        , y(0)
+        , i(0)
+        , j(0)
+    {}
+};
+
+#ifdef D3_HEXBIN_HAS_PMR
+namespace pmr {
+
+/// Bin, allocated from std::pmr::memory_resource
+template <typename T, typename NumberT>
+using HexbinBin = d3_hexbin::HexbinBin<T, NumberT, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace pmr
+#endif
+
+/**
+ * Non-standart: bin without points, returned by Hexbin::counts().
+ */
+template <typename NumberT>
+struct HexbinCount
+{
+    using number_t = NumberT;
+
+    /**
+     * The x-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t x;
+
+    /**
+     * The y-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t y;
+
+    /**
+     * The number of points in the associated bin.
+     */
+    std::size_t count;
+};
+
+/**
+ * Non-standart: hexagon coordinates of pointy-topped grid of Hexbin.
+ *
+ * Offset coordinates (column `i`, row `j`) are used by bins: odd rows are
+ * shifted right by half of hexagon (see HexbinBin::i & HexbinBin::j).
+ * Axial (`q`, `r`) & cube (`x`, `y`, `z`, where x + y + z == 0) coordinates
+ * make neighbours & distances arithmetic simple (see
+ * https://www.redblobgames.com/grids/hexagons/). Conversions are done by
+ * Hexbin static methods.
+ */
+struct HexbinOffset
+{
+    int i;
+    int j;
+
+    bool operator == (const HexbinOffset& other) const { return i == other.i && j == other.j; }
+    bool operator != (const HexbinOffset& other) const { return !(*this == other); }
+};
+
+struct HexbinAxial
+{
+    int q;
+    int r;
+
+    bool operator == (const HexbinAxial& other) const { return q == other.q && r == other.r; }
+    bool operator != (const HexbinAxial& other) const { return !(*this == other); }
+};
+
+struct HexbinCube
+{
+    int x;
+    int y;
+    int z;
+
+    bool operator == (const HexbinCube& other) const { return x == other.x && y == other.y && z == other.z; }
+    bool operator != (const HexbinCube& other) const { return !(*this == other); }
+};
+
+/**
+ * Non-standart: bins in compressed-sparse-row form, returned by Hexbin::csr()
+ * & Hexbin::csr_indices(). Items of all bins are stored in one flat array,
+ * k-th bin contains `items[bins[k].offset .. bins[k + 1].offset)` (so result
+ * takes 2 allocations).
+ */
+template <typename ItemT, typename NumberT>
+struct HexbinCsr
+{
+    using number_t = NumberT;
+    using item_t   = ItemT;
+
+    struct Bin {
+        number_t    x;      ///< The x-coordinate of the center of the bin’s hexagon
+        number_t    y;      ///< The y-coordinate of the center of the bin’s hexagon
+        std::size_t offset; ///< Offset of the first item of the bin in `items`
+    };
+
+    /// size() + 1 bins, last one is sentinel with `offset == items.size()`
+    std::vector<Bin>   bins;
+    std::vector<ItemT> items;
+
+    std::size_t size() const {
+        return bins.empty() ? 0 : bins.size() - 1;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t count(std::size_t k) const {
+        return bins[k + 1].offset - bins[k].offset;
+    }
+
+    const ItemT* begin(std::size_t k) const {
+        return items.data() + bins[k].offset;
+    }
+
+    const ItemT* end(std::size_t k) const {
+        return items.data() + bins[k + 1].offset;
+    }
+};
+
+/**
+ * Non-standart: reusable state of Hexbin::operator() - lookup tables, bins
+ * & their points storage, scratch buffers. Bins are kept between calls (with
+ * their capacity) and are reused by size rank (the largest bin gets the bin
+ * with the largest capacity), so repeated binning of similar points (e.g.
+ * per frame) makes no heap allocations in steady state.
+ *
+ * @code{.cpp}
+ * d3_hexbin::HexbinWorkspace<Datum, double> workspace;
+ * for (;;) { // every frame
+ *     const auto& bins = hexbin(points, workspace); // valid until next call
+ * }
+ * @endcode
+ */
+template <typename T, typename NumberT>
+class HexbinWorkspace
+{
+    template <typename, typename, typename, typename, typename>
+    friend class Hexbin;
+
+public:
+
+    using bin_t = HexbinBin<T, NumberT>;
+
+private:
+    detail::CellTable          _table;
+    detail::CellGrid           _grid;
+    std::vector<std::uint64_t> _keys;   // slot -> cell
+    std::vector<std::uint32_t> _slots;  // point -> slot
+    std::vector<std::size_t>   _sizes;  // slot -> points count
+    std::vector<std::size_t>   _order;  // bin -> slot
+    std::vector<std::size_t>   _rank;   // bins, by size descending
+    std::vector<std::size_t>   _where;  // slot -> bin
+    std::vector<std::string>   _ids;
+    std::vector<bin_t>         _bins;
+    std::vector<bin_t>         _spare;  // cleared bins (keeping capacity)
+
+    /**
+        Makes `_bins` of `_sizes` in `_order` (empty, with enough capacity).
+        Spare bins are matched to new bins by capacity & size ranks.
+     */
+    void _make_bins() {
+        const std::size_t count = _order.size();
+        while (_spare.size() < count)
+            _spare.push_back( bin_t(typename bin_t::allocator_type()) );
+        std::sort(_spare.begin(), _spare.end(), [](const bin_t& a, const bin_t& b) {
+            return a.capacity() > b.capacity();
+        });
+
+        _rank.resize(count);
+        for (std::size_t k = 0; k < count; ++k) _rank[k] = k;
+        std::sort(_rank.begin(), _rank.end(), [this](std::size_t a, std::size_t b) {
+            return _sizes[_order[a]] > _sizes[_order[b]];
+        });
+
+        _where.resize(count);
+        for (std::size_t r = 0; r < count; ++r) _where[_rank[r]] = r; // bin -> spare
+        for (std::size_t k = 0; k < count; ++k) {
+            _bins.push_back( std::move(_spare[_where[k]]) );
+            _bins.back().reserve(_sizes[_order[k]]);
+        }
+        _spare.erase(_spare.begin(), _spare.begin() + count);
+
+        for (std::size_t k = 0; k < count; ++k) _where[_order[k]] = k; // slot -> bin
+    }
+
+public:
+
+    /// Returns bins of the last call of Hexbin::operator()
+    const std::vector<bin_t>& bins() const {
+        return _bins;
+    }
+
+    /// Removes bins, keeping capacity
+    void clear() {
+        for (bin_t& bin : _bins) {
+            bin.clear();
+            _spare.push_back( std::move(bin) );
+        }
+        _bins.clear();
+    }
+
+    /// Releases all memory
+    void shrink() {
+        HexbinWorkspace().swap(*this);
+    }
+
+    void swap(HexbinWorkspace& other) {
+        std::swap(_table,  other._table);
+        std::swap(_grid,   other._grid);
+        _keys.swap(other._keys);
+        _order.swap(other._order);
+        _ids.swap(other._ids);
+        _slots.swap(other._slots);
+        _sizes.swap(other._sizes);
+        _rank.swap(other._rank);
+        _where.swap(other._where);
+        _bins.swap(other._bins);
+        _spare.swap(other._spare);
+    }
+};
+
+/**
+ * Non-standart: bin with aggregated value, returned by Hexbin::aggregate().
+ */
+template <typename ValueT, typename NumberT>
+struct HexbinAggregate
+{
+    using number_t = NumberT;
+    using value_t  = ValueT;
+
+    /**
+     * The x-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t x;
+
+    /**
+     * The y-coordinate of the center of the associated bin’s hexagon.
+     */
+    number_t y;
+
+    /**
+     * The finalized aggregator state of points in the associated bin.
+     */
+    value_t value;
+};
+
+/**
+    Non-standart: partial (mergeable) binning result of one shard of points,
+    returned by Hexbin::partial() & Hexbin::partial_indices().
+
+    Bins are keyed by packed (pi, pj) cells and kept in `by_cell` order, so
+    partials are merged by one O(bins) pass. Per-bin state is aggregator
+    state (Hexbin::partial()) or list of points indices (Hexbin::partial_indices()).
+    Merged partial of consecutive shards is the same, as partial of
+    concatenated shards - it's finalized into bins by Hexbin::aggregate(),
+    Hexbin::counts() or Hexbin::indices() overloads.
+
+    Merging & binary encoding are in "partial.hpp".
+
+    @code{.cpp}
+    auto a = hexbin.partial(shard_a, d3_hexbin::aggregate::count());
+    auto b = hexbin.partial(shard_b, d3_hexbin::aggregate::count());
+    std::vector<std::uint8_t> bytes = d3_hexbin::encode(b); // send to other process
+    d3_hexbin::decode(bytes, b);
+    const auto bins = hexbin.counts( d3_hexbin::merge(a, b, d3_hexbin::aggregate::count()) );
+    // same as hexbin.counts(shard_a + shard_b)
+    @endcode
+ */
+template <typename StateT>
+struct HexbinPartial
+{
+    using state_t = StateT;
+
+    /// Input points count (indices of next shard points are shifted by it)
+    std::uint64_t              points = 0;
+
+    /// Bin -> packed (pi, pj) cell, in `by_cell` order
+    std::vector<std::uint64_t> cells;
+
+    /// Bin -> index of its first point (for `first_seen` order)
+    std::vector<std::uint64_t> firsts;
+
+    /// Bin -> state
+    std::vector<StateT>        states;
+
+    std::size_t size() const {
+        return cells.size();
+    }
+
+    bool empty() const {
+        return cells.empty();
+    }
+};
+
+/**
+ * Cells lookup structure, used by Hexbin::operator().
+ */
+enum class HexbinEngine
+{
+    /// Open-addressing hash table on packed (pi, pj) keys (default).
+    hash,
+
+    /// Flat array of cells, covering current extent(). Points out of extent
+    /// are binned through fallback hash table (or skipped, if clip() is set).
+    /// Falls back to `hash` engine, if extent contains too many cells (or
+    /// much more cells, than points). Grid is allocated & filled per call -
+    /// use HexbinWorkspace for repeated binning (like re-binning of viewport
+    /// on every frame), it keeps grid allocated.
+    dense,
+
+    /// Packed (pi, pj) key is computed per point, then (key, index) pairs
+    /// are sorted by LSD radix sort and bins are emitted by one scan. Uses
+    /// O(points) extra memory, bins are naturally in `by_cell` order.
+    /// Multi-threaded binning uses `hash` engine instead.
+    sort
+};
+
+/**
+ * Order of bins, returned by Hexbin::operator().
+ */
+enum class HexbinOrder
+{
+    /// Sorted by "pi-pj" string ids - the same order as in original
+    /// `std::map<std::string, ...>` based implementation (default).
+    by_id,
+
+    /// Order of first appearance in input points - no extra sorting.
+    first_seen,
+
+    /// Sorted by cells rows, then columns: (pj, pi), numerically.
+    by_cell
+};
+
+template <typename HexbinT>
+class HexbinAccumulator;
+
+template <typename HexbinT>
+class HexbinWindow;
+
+template <typename HexbinT>
+class HexbinCsv;
+
+template <typename HexbinT>
+class HexbinCache;
+
+/**
+ * XAccessor & YAccessor are compile-time accessor policies (function objects
+ * or lambdas), used by binning loop directly. Type-erased accessors, set via
+ * x() & y() setters, override them.
+ */
+template <typename T, typename number_t, typename PointT = std::array<number_t, 2>,
+          typename XAccessor = detail::PointX<T, number_t>,
+          typename YAccessor = detail::PointY<T, number_t> >
+class Hexbin {
+public:
+
+    using component_func_t = std::function< number_t (const T& ) >;
+
+    using x_accessor_t = XAccessor;
+    using y_accessor_t = YAccessor;
+
+    using extent_t = std::array<PointT, 2>;
+
+    using datum_t = T;
+    using bin_t   = HexbinBin<T, number_t>;
+
+private:
+    template <typename HexbinT>
+    friend class HexbinAccumulator;
+
+    template <typename HexbinT>
+    friend class HexbinWindow;
+
+    template <typename HexbinT>
+    friend class HexbinCsv;
+
+    template <typename HexbinT>
+    friend class HexbinCache;
+
+    number_t x0 = 0;
+    number_t y0 = 0;
+    number_t x1 = 1;
+    number_t y1 = 1;
+    XAccessor _x_accessor;
+    YAccessor _y_accessor;
+    component_func_t _x; // empty, if not set
+    component_func_t _y; // empty, if not set
+    number_t r;
+    number_t dx;
+    number_t dy;
+    HexbinOrder _order = HexbinOrder::by_id;
+    HexbinEngine _engine = HexbinEngine::hash;
+    bool _clip = false;
+
+    // -------------------------------------------------------------------------
+protected:
+
+    // NOTICE: that this method returns RELATIVE coordinates (dx, dy),
+    // not absolute coords.
+    static std::array<PointT, 6> _hexagon(number_t radius) {
+        number_t x0 = 0, y0 = 0;
+
+        std::array<PointT, 6> result;
+        for(std::size_t i = 0; i < detail::angles.size(); ++i)
+        {
+            const auto& angle = detail::angles[i];
+
+            const number_t
+                    x1 =  std::sin(angle) * radius,
+                    y1 = -std::cos(angle) * radius,
+                    dx = x1 - x0,
+                    dy = y1 - y0;
+            x0 = x1; y0 = y1;
+            result[i] = {dx, dy};
+        }
+        return result;
+    }
+
+    // -------------------------------------------------------------------------
+    // Utils (stringification)
+
+    template <typename ValueT>
+    static inline std::string _to_str(const ValueT& val) {
+        std::ostringstream out;
+        out << val;
+        return out.str();
+    }
+
+    static inline std::string _p_to_str(const PointT& p) {
+        return _to_str(p[0]) + "," + _to_str(p[1]);
+    }
+
+    static inline std::string _join(const std::vector<std::string>& list, const std::string& delim) {
+        return std::accumulate(list.begin(), list.end(), std::string(), // via: https://stackoverflow.com/a/12155571
+                   [&delim](const std::string& a, const std::string& b) -> std::string {
+                       return a + (a.length() > 0 ? delim : "") + b;
+               });
+    }
+
+    // -------------------------------------------------------------------------
+
+    static std::vector<std::string> _hexagon_str(number_t radius) {
+        std::vector<std::string> strings;
+        const auto points = _hexagon(radius);
+        for(const PointT& point : points) {
+            strings.push_back( _p_to_str(point) );
+        }
+        return strings;
+    }
+
+    // -------------------------------------------------------------------------
+    // Binning core
+
+    /**
+        Quantizes point (px, py) into hexagon offset coordinates (pi, pj).
+        Returns false for points with NaN coordinate (they are skipped).
+     */
+    bool _cell(number_t px, number_t py, int& pi, int& pj) const
+    {
+        detail::quantize(px, py, dx, dy, pi, pj);
+        return (pi != detail::invalid_cell);
+    }
+
+    /**
+        Same as _cell(), but for datum: applies accessors & clip().
+     */
+    bool _cell(const T& point, int& pi, int& pj) const
+    {
+        const number_t px = (_x ? _x(point) : _x_accessor(point));
+        const number_t py = (_y ? _y(point) : _y_accessor(point));
+        if (_clip && !_inside(px, py)) return false;
+        return _cell(px, py, pi, pj);
+    }
+
+    number_t _center_x(int pi, int pj) const {
+        return (pi + (pj & 1) / 2.0) * dx; /// '2.0' instead '2' important here too
+    }
+
+    number_t _center_y(int pj) const {
+        return pj * dy;
+    }
+
+    // Sets center & offset coordinates of bin
+    template <typename BinT>
+    void _place(BinT& bin, int pi, int pj) const {
+        bin.x = _center_x(pi, pj);
+        bin.y = _center_y(pj);
+        bin.i = pi;
+        bin.j = pj;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Source provides points coordinates by blocks:
+            - `size()`                       - number of points
+            - `load(base, count, xs, ys)`    - coordinates of points [base, base + count)
+     */
+    template <typename XFunc, typename YFunc>
+    struct _PointsSource
+    {
+        const std::vector<T>& points;
+        XFunc x;
+        YFunc y;
+
+        std::size_t size() const {
+            return points.size();
+        }
+
+        void load(std::size_t base, std::size_t count, number_t* xs, number_t* ys) const {
+            for (std::size_t k = 0; k < count; ++k) {
+                const T& point = points[base + k];
+                xs[k] = x(point /*, i, points*/);
+                ys[k] = y(point /*, i, points*/);
+            }
+        }
+    };
+
+    template <typename XColumn, typename YColumn>
+    struct _ColumnsSource
+    {
+        const XColumn& xs;
+        const YColumn& ys;
+        std::size_t    n;
+
+        std::size_t size() const {
+            return n;
+        }
+
+        void load(std::size_t base, std::size_t count, number_t* bxs, number_t* bys) const {
+            for (std::size_t k = 0; k < count; ++k) {
+                bxs[k] = xs[base + k];
+                bys[k] = ys[base + k];
+            }
+        }
+    };
+
+    /**
+        Sink receives binned points:
+            - `open(pi, pj, index)` - first point of new bin (next slot)
+            - `add(slot, index)`    - next point of existing bin
+            - `permute(order)`      - reorders bins according to `_order`
+     */
+    template <typename Sink>
+    void _bin(const std::vector<T>& points, Sink& sink) const
+    {
+        if (_x || _y)
+            _bin(_PointsSource<component_func_t, component_func_t>{points, x(), y()}, sink);
+        else
+            _bin(_PointsSource<XAccessor, YAccessor>{points, _x_accessor, _y_accessor}, sink);
+    }
+
+    template <typename Source, typename Sink>
+    void _bin(const Source& source, Sink& sink) const
+    {
+        if (_engine == HexbinEngine::sort) {
+            _bin_sorted(source, sink);
+            return;
+        }
+
+        if (_engine == HexbinEngine::dense) {
+            detail::CellGrid grid;
+            if (_reset_grid(grid, source.size())) {
+                _bin(source, grid, sink);
+                return;
+            }
+        }
+
+        detail::CellTable table;
+        _bin(source, table, sink);
+    }
+
+    template <typename Source, typename Cells, typename Sink>
+    void _bin(const Source& source, Cells& cells, Sink& sink) const
+    {
+        std::vector<std::uint64_t> keys;
+        _bin(source, 0, source.size(), cells, keys, sink);
+        _arrange(keys, sink);
+    }
+
+    // Bins points [begin, end) of source. Cells of new bins are appended to `keys`.
+    template <typename Source, typename Cells, typename Sink>
+    void _bin(const Source& source, std::size_t begin, std::size_t end, Cells& cells, std::vector<std::uint64_t>& keys, Sink& sink) const
+    {
+        number_t xs[detail::block_size], ys[detail::block_size];
+        int      is[detail::block_size], js[detail::block_size];
+
+        for (std::size_t base = begin; base < end; base += detail::block_size)
+        {
+            const std::size_t count = std::min(detail::block_size, end - base);
+            source.load(base, count, xs, ys);
+            if (_clip) _clip_block(xs, ys, count);
+            detail::quantize(xs, ys, count, dx, dy, is, js);
+
+            for (std::size_t k = 0; k < count; ++k)
+            {
+                const int pi = is[k], pj = js[k];
+                if (pi == detail::invalid_cell) continue;
+
+                const auto found = cells.insert(pi, pj, static_cast<std::uint32_t>(keys.size()));
+                if (found.second) { // not found - new bin
+                    keys.push_back( detail::pack_cell(pi, pj) );
+                    sink.open(pi, pj, base + k);
+                } else {
+                    sink.add(found.first, base + k);
+                }
+            }
+        }
+    }
+
+    template <typename Source, typename Sink>
+    void _bin_range(const Source& source, std::size_t begin, std::size_t end, std::vector<std::uint64_t>& keys, Sink& sink) const
+    {
+        if (_engine == HexbinEngine::dense) {
+            detail::CellGrid grid;
+            if (_reset_grid(grid, end - begin)) {
+                _bin(source, begin, end, grid, keys, sink);
+                return;
+            }
+        }
+
+        detail::CellTable table;
+        _bin(source, begin, end, table, keys, sink);
+    }
+
+    // Writes packed cell key of each point of source into `out` (no bins are built)
+    template <typename Source>
+    void _bin_ids(const Source& source, std::uint64_t* out) const
+    {
+        number_t xs[detail::block_size], ys[detail::block_size];
+        int      is[detail::block_size], js[detail::block_size];
+
+        const std::size_t n = source.size();
+        for (std::size_t base = 0; base < n; base += detail::block_size)
+        {
+            const std::size_t count = std::min(detail::block_size, n - base);
+            source.load(base, count, xs, ys);
+            if (_clip) _clip_block(xs, ys, count);
+            detail::quantize(xs, ys, count, dx, dy, is, js);
+
+            for (std::size_t k = 0; k < count; ++k)
+                out[base + k] = (is[k] != detail::invalid_cell) ? detail::pack_cell(is[k], js[k]) : detail::no_cell;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Multi-threaded binning
+
+    /**
+        Bins layout in compressed-sparse-row form: k-th bin (in `_order`) has
+        cell `cells[k]` and contains points `indices[offsets[k] .. offsets[k + 1])`
+        in input order.
+     */
+    struct _Layout
+    {
+        std::vector<std::uint64_t> cells;
+        std::vector<std::size_t>   offsets;
+        std::vector<std::size_t>   indices;
+    };
+
+    // Records chunk-local bin slot of each point of chunk
+    struct _SlotsSink
+    {
+        std::size_t                 begin;
+        std::vector<std::uint32_t>& slots;
+        std::vector<std::size_t>&   sizes;
+
+        void open(int /*pi*/, int /*pj*/, std::size_t index) {
+            slots[index - begin] = static_cast<std::uint32_t>(sizes.size());
+            sizes.push_back(1);
+        }
+
+        void add(std::size_t slot, std::size_t index) {
+            slots[index - begin] = static_cast<std::uint32_t>(slot);
+            ++sizes[slot];
+        }
+    };
+
+    // Cells key space partition of merge
+    static std::size_t _partition(std::uint64_t key, std::size_t partitions) {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 40) % partitions;
+    }
+
+    /**
+        Splits points into contiguous chunks (one per thread), bins each chunk
+        into thread-local table, then merges chunks tables and fills points
+        indices of bins in parallel. Result doesn't depend on threads count.
+
+        Merge is partitioned by cells keys: each thread merges bins of its
+        partition of key space (of all chunks, in chunks order) into its own
+        table, then global bins are numbered in order of first appearance by
+        per-chunk prefix sums. Only ordering of bins (for by_id & by_cell
+        orders) & offsets computation are serial - O(bins), not O(chunks bins).
+     */
+    template <typename Source>
+    _Layout _layout(const Source& source, unsigned threads) const
+    {
+        struct Chunk {
+            std::size_t begin, end;
+            std::vector<std::uint64_t> keys;   // local bin -> cell
+            std::vector<std::uint32_t> slots;  // point - begin -> local bin
+            std::vector<std::size_t>   sizes;  // local bin -> points count
+            std::vector<std::size_t>   remap;  // local bin -> partition bin, then global bin
+            std::vector<std::size_t>   cursor; // local bin -> next position in indices
+            std::vector<std::uint8_t>  first;  // local bin -> first appearance of cell
+            std::vector<std::vector<std::uint32_t>> parts; // partition -> local bins
+            std::size_t                base;   // global index of first new bin of chunk
+        };
+
+        struct Partition {
+            std::vector<std::uint64_t> keys;   // partition bin -> cell
+            std::vector<std::size_t>   sizes;  // partition bin -> points count
+            std::vector<std::size_t>   global; // partition bin -> global bin
+        };
+
+        const std::size_t n = source.size();
+        const std::size_t blocks = (n + detail::block_size - 1) / detail::block_size;
+        const std::size_t count = std::max<std::size_t>(1, std::min<std::size_t>(threads, blocks));
+
+        std::vector<Chunk> chunks(count);
+        detail::parallel_for(count, threads, [&](std::size_t c) {
+            Chunk& chunk = chunks[c];
+            chunk.begin = n * c / count;
+            chunk.end   = n * (c + 1) / count;
+            chunk.slots.assign(chunk.end - chunk.begin, detail::no_slot);
+
+            _SlotsSink sink{chunk.begin, chunk.slots, chunk.sizes};
+            _bin_range(source, chunk.begin, chunk.end, chunk.keys, sink);
+
+            chunk.remap.resize(chunk.keys.size());
+            chunk.cursor.resize(chunk.keys.size());
+            chunk.first.assign(chunk.keys.size(), 0);
+            chunk.parts.resize(count);
+            for (std::size_t l = 0; l < chunk.keys.size(); ++l)
+                chunk.parts[_partition(chunk.keys[l], count)].push_back(static_cast<std::uint32_t>(l));
+        });
+
+        // Merge partitions: cursors are relative to global bin begin
+        std::vector<Partition> partitions(count);
+        detail::parallel_for(count, threads, [&](std::size_t p) {
+            Partition& part = partitions[p];
+            detail::CellTable table;
+            for (Chunk& chunk : chunks) {
+                for (const std::uint32_t l : chunk.parts[p]) {
+                    const auto found = table.insert(chunk.keys[l], static_cast<std::uint32_t>(part.keys.size()));
+                    if (found.second) {
+                        part.keys.push_back(chunk.keys[l]);
+                        part.sizes.push_back(0);
+                        chunk.first[l] = 1;
+                    }
+                    chunk.remap[l]  = found.first;
+                    chunk.cursor[l] = part.sizes[found.first];
+                    part.sizes[found.first] += chunk.sizes[l];
+                }
+            }
+            part.global.resize(part.keys.size());
+        });
+
+        // Global bins are in order of first appearance
+        std::size_t bins = 0;
+        for (Chunk& chunk : chunks) {
+            chunk.base = bins;
+            bins += static_cast<std::size_t>(std::count(chunk.first.begin(), chunk.first.end(), 1));
+        }
+
+        std::vector<std::uint64_t> keys(bins);
+        std::vector<std::size_t>   sizes(bins);
+        detail::parallel_for(count, threads, [&](std::size_t c) {
+            Chunk& chunk = chunks[c];
+            std::size_t g = chunk.base;
+            for (std::size_t l = 0; l < chunk.keys.size(); ++l) {
+                if (!chunk.first[l]) continue;
+                Partition& part = partitions[_partition(chunk.keys[l], count)];
+                part.global[chunk.remap[l]] = g;
+                keys[g]  = chunk.keys[l];
+                sizes[g] = part.sizes[chunk.remap[l]];
+                ++g;
+            }
+        });
+        detail::parallel_for(count, threads, [&](std::size_t c) {
+            Chunk& chunk = chunks[c];
+            for (std::size_t l = 0; l < chunk.keys.size(); ++l)
+                chunk.remap[l] = partitions[_partition(chunk.keys[l], count)].global[chunk.remap[l]];
+        });
+
+        std::vector<std::size_t> order;
+        if (_order == HexbinOrder::first_seen) {
+            order.resize(keys.size());
+            for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+        } else {
+            order = _ordering(keys);
+        }
+
+        _Layout layout;
+        layout.cells.resize(keys.size());
+        layout.offsets.resize(keys.size() + 1);
+        std::vector<std::size_t> begins(keys.size());
+        std::size_t offset = 0;
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            layout.cells[k]   = keys[order[k]];
+            layout.offsets[k] = offset;
+            begins[order[k]]  = offset;
+            offset += sizes[order[k]];
+        }
+        layout.offsets.back() = offset;
+        layout.indices.resize(offset);
+
+        detail::parallel_for(count, threads, [&](std::size_t c) {
+            Chunk& chunk = chunks[c];
+            for (std::size_t l = 0; l < chunk.cursor.size(); ++l)
+                chunk.cursor[l] += begins[chunk.remap[l]];
+            for (std::size_t i = 0; i < chunk.slots.size(); ++i) {
+                const std::uint32_t slot = chunk.slots[i];
+                if (slot != detail::no_slot)
+                    layout.indices[chunk.cursor[slot]++] = chunk.begin + i;
+            }
+        });
+
+        return layout;
+    }
+
+    _Layout _layout(const std::vector<T>& points, unsigned threads) const
+    {
+        if (_x || _y)
+            return _layout(_PointsSource<component_func_t, component_func_t>{points, x(), y()}, threads);
+        else
+            return _layout(_PointsSource<XAccessor, YAccessor>{points, _x_accessor, _y_accessor}, threads);
+    }
+
+    template <typename ItemT, typename GetItem>
+    std::vector<HexbinBin<ItemT, number_t>> _bins(const _Layout& layout, const GetItem& item, unsigned threads) const
+    {
+        using bin_t = HexbinBin<ItemT, number_t>;
+
+        std::vector<bin_t> bins;
+        bins.reserve(layout.cells.size());
+        for (std::size_t k = 0; k < layout.cells.size(); ++k) {
+            const int pi = detail::cell_i(layout.cells[k]), pj = detail::cell_j(layout.cells[k]);
+            bins.emplace_back( item(layout.indices[layout.offsets[k]]) );
+            _place(bins.back(), pi, pj);
+        }
+
+        detail::parallel_for(threads, threads, [&](std::size_t t) {
+            for (std::size_t k = t; k < bins.size(); k += threads) {
+                bin_t& bin = bins[k];
+                bin.reserve(layout.offsets[k + 1] - layout.offsets[k]);
+                for (std::size_t i = layout.offsets[k] + 1; i < layout.offsets[k + 1]; ++i)
+                    bin.push_back( item(layout.indices[i]) );
+            }
+        });
+        return bins;
+    }
+
+    template <typename ItemT, typename GetItem>
+    HexbinCsr<ItemT, number_t> _csr(const _Layout& layout, const GetItem& item) const
+    {
+        HexbinCsr<ItemT, number_t> csr;
+        csr.bins.reserve(layout.cells.size() + 1);
+        for (std::size_t k = 0; k < layout.cells.size(); ++k) {
+            const int pi = detail::cell_i(layout.cells[k]), pj = detail::cell_j(layout.cells[k]);
+            csr.bins.push_back({_center_x(pi, pj), _center_y(pj), layout.offsets[k]});
+        }
+        csr.bins.push_back({0, 0, layout.indices.size()});
+
+        csr.items.reserve(layout.indices.size());
+        for (const std::size_t index : layout.indices)
+            csr.items.push_back( item(index) );
+        return csr;
+    }
+
+    // Marks points out of extent as NaN (skipped)
+    void _clip_block(number_t* xs, number_t* ys, std::size_t count) const {
+        for (std::size_t k = 0; k < count; ++k)
+            if (!_inside(xs[k], ys[k])) xs[k] = std::numeric_limits<number_t>::quiet_NaN();
+    }
+
+    bool _inside(number_t px, number_t py) const {
+        return (px >= x0 && px <= x1 && py >= y0 && py <= y1);
+    }
+
+    /**
+        Grid covers all cells of points inside extent (with 1 cell margin).
+        Returns false (hash engine is used), if grid is too large for binning
+        of `points` points (see `detail::dense_cells_per_point`) or extent is
+        not finite or out of int64 cells range.
+     */
+    bool _reset_grid(detail::CellGrid& grid, std::size_t points) const {
+        const double bounds[4] = {std::floor(static_cast<double>(x0 / dx)), std::floor(static_cast<double>(y0 / dy)),
+                                  std::ceil (static_cast<double>(x1 / dx)), std::ceil (static_cast<double>(y1 / dy))};
+        for (const double bound : bounds) {
+            if (!std::isfinite(bound) || std::abs(bound) >= 4611686018427387904.0) return false; // 2^62
+        }
+
+        const std::size_t max_cells = std::max(detail::min_dense_cells,
+            points > detail::max_dense_cells / detail::dense_cells_per_point ? detail::max_dense_cells
+                                                                             : points * detail::dense_cells_per_point);
+        return grid.reset(
+            static_cast<std::int64_t>(bounds[0]) - 1, static_cast<std::int64_t>(bounds[1]) - 1,
+            static_cast<std::int64_t>(bounds[2]) + 1, static_cast<std::int64_t>(bounds[3]) + 1,
+            max_cells);
+    }
+
+    // Bins with `keys` are in order of first appearance
+    template <typename Sink>
+    void _arrange(const std::vector<std::uint64_t>& keys, Sink& sink) const
+    {
+        if (_order != HexbinOrder::first_seen)
+            sink.permute( _ordering(keys) );
+    }
+
+    std::vector<std::size_t> _ordering(const std::vector<std::uint64_t>& keys) const
+    {
+        return (_order == HexbinOrder::by_id) ? detail::order_by_id(keys)
+                                              : detail::order_by_cell(keys);
+    }
+
+    // -------------------------------------------------------------------------
+    // Binning into workspace
+
+    /**
+        Bins points in 2 passes: records bin slot of each point (& bins
+        sizes), then fills bins of known sizes.
+     */
+    template <typename Source>
+    void _bin(const Source& source, const std::vector<T>& points, HexbinWorkspace<T, number_t>& workspace) const
+    {
+        HexbinWorkspace<T, number_t>& ws = workspace;
+        ws.clear();
+        ws._keys.clear();
+        ws._sizes.clear();
+        ws._slots.assign(points.size(), detail::no_slot);
+
+        _SlotsSink sink{0, ws._slots, ws._sizes};
+        if (_engine == HexbinEngine::dense && _reset_grid(ws._grid, source.size())) {
+            _bin(source, 0, source.size(), ws._grid, ws._keys, sink);
+        } else {
+            ws._table.clear();
+            _bin(source, 0, source.size(), ws._table, ws._keys, sink);
+        }
+        if (ws._keys.empty()) return;
+
+        if (_order == HexbinOrder::by_id) {
+            detail::order_by_id(ws._keys, ws._order, ws._ids);
+        } else if (_order == HexbinOrder::by_cell) {
+            detail::order_by_cell(ws._keys, ws._order);
+        } else {
+            ws._order.resize(ws._keys.size());
+            for (std::size_t k = 0; k < ws._order.size(); ++k) ws._order[k] = k;
+        }
+
+        ws._make_bins();
+        for (std::size_t k = 0; k < ws._bins.size(); ++k) {
+            const std::uint64_t cell = ws._keys[ws._order[k]];
+            const int pi = detail::cell_i(cell), pj = detail::cell_j(cell);
+            _place(ws._bins[k], pi, pj);
+        }
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            const std::uint32_t slot = ws._slots[i];
+            if (slot != detail::no_slot)
+                ws._bins[ws._where[slot]].push_back(points[i]);
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Sort engine
+
+    template <typename Source, typename Sink>
+    void _bin_sorted(const Source& source, Sink& sink) const
+    {
+        const std::size_t n = source.size();
+        std::vector<std::uint64_t> keys;
+        std::vector<std::size_t>   indices;
+        keys.reserve(n);
+        indices.reserve(n);
+
+        number_t xs[detail::block_size], ys[detail::block_size];
+        int      is[detail::block_size], js[detail::block_size];
+        for (std::size_t base = 0; base < n; base += detail::block_size)
+        {
+            const std::size_t count = std::min(detail::block_size, n - base);
+            source.load(base, count, xs, ys);
+            if (_clip) _clip_block(xs, ys, count);
+            detail::quantize(xs, ys, count, dx, dy, is, js);
+
+            for (std::size_t k = 0; k < count; ++k) {
+                if (is[k] == detail::invalid_cell) continue;
+                keys.push_back( detail::pack_sortable_cell(is[k], js[k]) );
+                indices.push_back(base + k);
+            }
+        }
+
+        detail::radix_sort(keys, indices);
+
+        // Segmented scan: bins are in (pj, pi) order, points in input order
+        std::vector<std::uint64_t> cells;
+        std::vector<std::size_t>   firsts;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (i == 0 || keys[i] != keys[i - 1]) {
+                const std::uint64_t cell = detail::sortable_to_cell(keys[i]);
+                cells.push_back(cell);
+                firsts.push_back(indices[i]);
+                sink.open(detail::cell_i(cell), detail::cell_j(cell), indices[i]);
+            } else {
+                sink.add(cells.size() - 1, indices[i]);
+            }
+        }
+
+        if (_order == HexbinOrder::by_id) {
+            sink.permute( detail::order_by_id(cells) );
+        } else if (_order == HexbinOrder::first_seen) {
+            std::vector<std::size_t> order(cells.size());
+            for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+            std::sort(order.begin(), order.end(), [&firsts](std::size_t a, std::size_t b) {
+                return firsts[a] < firsts[b];
+            });
+            sink.permute(order);
+        }
+    }
+
+    struct _PointAt {
+        const std::vector<T>& points;
+        const T& operator () (std::size_t index) const { return points[index]; }
+    };
+
+    // Points are moved into bins
+    struct _MovePointAt {
+        std::vector<T>& points;
+        T&& operator () (std::size_t index) const { return std::move(points[index]); }
+    };
+
+    template <typename IndexT>
+    struct _IndexOf {
+        IndexT operator () (std::size_t index) const { return static_cast<IndexT>(index); }
+    };
+
+    template <typename ItemT, typename Allocator>
+    using _bins_t = std::vector<HexbinBin<ItemT, number_t, Allocator>,
+                                typename std::allocator_traits<Allocator>::template rebind_alloc<HexbinBin<ItemT, number_t, Allocator>>>;
+
+    template <typename ItemT, typename GetItem, typename Allocator = std::allocator<ItemT>>
+    struct _BinsSink
+    {
+        using bin_t = HexbinBin<ItemT, number_t, Allocator>;
+
+        const Hexbin&                     hexbin;
+        GetItem                           item;
+        _bins_t<ItemT, Allocator>         bins;
+
+        void open(int pi, int pj, std::size_t index) {
+            bins.push_back( bin_t(item(index), Allocator(bins.get_allocator())) );
+            hexbin._place(bins.back(), pi, pj);
+        }
+
+        void add(std::size_t slot, std::size_t index) {
+            bins[slot].push_back( item(index) );
+        }
+
+        void permute(const std::vector<std::size_t>& order) {
+            detail::permute(bins, order);
+        }
+    };
+
+    struct _CountsSink
+    {
+        const Hexbin&                       hexbin;
+        std::vector<HexbinCount<number_t>>  bins;
+
+        void open(int pi, int pj, std::size_t /*index*/) {
+            bins.push_back({hexbin._center_x(pi, pj), hexbin._center_y(pj), 1});
+        }
+
+        void add(std::size_t slot, std::size_t /*index*/) {
+            ++bins[slot].count;
+        }
+
+        void permute(const std::vector<std::size_t>& order) {
+            detail::permute(bins, order);
+        }
+    };
+
+    template <typename Aggregator>
+    struct _AggregateSink
+    {
+        using state_t = typename Aggregator::state_t;
+
+        const Hexbin&         hexbin;
+        const std::vector<T>& points;
+        const Aggregator&     aggregator;
+        std::vector<std::uint64_t> cells;
+        std::vector<state_t>       states;
+
+        void open(int pi, int pj, std::size_t index) {
+            cells.push_back( detail::pack_cell(pi, pj) );
+            states.push_back( aggregator.init() );
+            aggregator.accumulate(states.back(), points[index]);
+        }
+
+        void add(std::size_t slot, std::size_t index) {
+            aggregator.accumulate(states[slot], points[index]);
+        }
+
+        void permute(const std::vector<std::size_t>& order) {
+            detail::permute(cells, order);
+            detail::permute(states, order);
+        }
+
+        std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>> finalize() const {
+            std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>> bins;
+            bins.reserve(states.size());
+            for(std::size_t i = 0; i < states.size(); ++i) {
+                const int pi = detail::cell_i(cells[i]), pj = detail::cell_j(cells[i]);
+                bins.push_back({hexbin._center_x(pi, pj), hexbin._center_y(pj), aggregator.finalize(states[i])});
+            }
+            return bins;
+        }
+    };
+
+    // Partial bins: states are made by `Policy::open(index)`, updated by
+    // `Policy::add(state, index)`
+    template <typename StateT, typename Policy>
+    struct _PartialSink
+    {
+        const Policy&              policy;
+        std::vector<std::uint64_t> cells;
+        std::vector<std::uint64_t> firsts;
+        std::vector<StateT>        states;
+
+        void open(int pi, int pj, std::size_t index) {
+            cells.push_back( detail::pack_cell(pi, pj) );
+            firsts.push_back(index);
+            states.push_back( policy.open(index) );
+        }
+
+        void add(std::size_t slot, std::size_t index) {
+            policy.add(states[slot], index);
+        }
+
+        void permute(const std::vector<std::size_t>& order) {
+            detail::permute(cells,  order);
+            detail::permute(firsts, order);
+            detail::permute(states, order);
+        }
+    };
+
+    template <typename Aggregator>
+    struct _AggregatePolicy {
+        const std::vector<T>& points;
+        const Aggregator&     aggregator;
+
+        typename Aggregator::state_t open(std::size_t index) const {
+            typename Aggregator::state_t state = aggregator.init();
+            aggregator.accumulate(state, points[index]);
+            return state;
+        }
+
+        void add(typename Aggregator::state_t& state, std::size_t index) const {
+            aggregator.accumulate(state, points[index]);
+        }
+    };
+
+    template <typename IndexT>
+    struct _IndexListPolicy {
+        std::vector<IndexT> open(std::size_t index) const {
+            return std::vector<IndexT>(1, static_cast<IndexT>(index));
+        }
+
+        void add(std::vector<IndexT>& state, std::size_t index) const {
+            state.push_back( static_cast<IndexT>(index) );
+        }
+    };
+
+    template <typename StateT, typename Policy>
+    HexbinPartial<StateT> _partial(const std::vector<T>& points, const Policy& policy) const
+    {
+        // Partial is always in `by_cell` order (natural order of sort engine),
+        // configured order is applied only to merged partials
+        Hexbin binner(*this);
+        binner._order = HexbinOrder::by_cell;
+
+        _PartialSink<StateT, Policy> sink{policy, {}, {}, {}};
+        binner._bin(points, sink);
+
+        HexbinPartial<StateT> partial;
+        partial.points = points.size();
+        partial.cells  = std::move(sink.cells);
+        partial.firsts = std::move(sink.firsts);
+        partial.states = std::move(sink.states);
+        return partial;
+    }
+
+    // Bins order of partial (which is in `by_cell` order)
+    template <typename StateT>
+    std::vector<std::size_t> _partial_order(const HexbinPartial<StateT>& partial) const
+    {
+        if (_order == HexbinOrder::by_id)
+            return detail::order_by_id(partial.cells);
+
+        std::vector<std::size_t> order(partial.size());
+        for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+        if (_order == HexbinOrder::first_seen) {
+            std::sort(order.begin(), order.end(), [&partial](std::size_t a, std::size_t b) {
+                return partial.firsts[a] < partial.firsts[b];
+            });
+        }
+        return order;
+    }
+
+public:
 
-template <typename DatumT, typename NumberT>
-inline
-    typename std::enable_if< detect::has_subscript<DatumT>::value == false, NumberT >::type
-pointX(const DatumT& /*d*/) {
-    static_assert(std::numeric_limits<NumberT>::has_quiet_NaN == true, "NumberT doesn't have NaN support");
-    return std::numeric_limits<NumberT>::quiet_NaN();
-}
+    Hexbin()
+    {
+        radius(1);
+    }
 
-template <typename DatumT, typename NumberT>
-inline
-    typename std::enable_if< detect::has_subscript<DatumT>::value == true, NumberT >::type
-pointX(const DatumT& d) {
-    return d[0];
-}
+    Hexbin(const XAccessor& x_, const YAccessor& y_)
+        : _x_accessor(x_)
+        , _y_accessor(y_)
+    {
+        radius(1);
+    }
 
-// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-template <typename DatumT, typename NumberT>
-inline
-    typename std::enable_if< detect::has_subscript<DatumT>::value == false, NumberT >::type
-pointY(const DatumT& /*d*/) {
-    static_assert(std::numeric_limits<NumberT>::has_quiet_NaN == true, "NumberT doesn't have NaN support");
-    return std::numeric_limits<NumberT>::quiet_NaN();
-}
+    std::vector<HexbinBin<T, number_t>> operator () (const std::vector<T>& points) const
+    {
+        _BinsSink<T, _PointAt> sink{*this, _PointAt{points}, {}};
+        _bin(points, sink);
+        return std::move(sink.bins);
+    }
 
-template <typename DatumT, typename NumberT>
-inline
-    typename std::enable_if< detect::has_subscript<DatumT>::value == true, NumberT >::type
-pointY(const DatumT& d) {
-    return d[1];
-}
+    /**
+        Non-standart: same as operator(), but points are moved into bins
+        (instead of copying), `points` are left in valid but unspecified
+        state.
+     */
+    std::vector<HexbinBin<T, number_t>> operator () (std::vector<T>&& points) const
+    {
+        _BinsSink<T, _MovePointAt> sink{*this, _MovePointAt{points}, {}};
+        _bin(points, sink);
+        return std::move(sink.bins);
+    }
 
-// -----------------------------------------------------------------------------
+    /**
+        Non-standart: same as operator(), but result & points of bins are
+        allocated by `alloc` (rebound to bins & points types). For example,
+        whole result may be placed in monotonic arena & released at once:
+
+        @code{.cpp}
+        std::pmr::monotonic_buffer_resource arena;
+        const auto bins = hexbin(points, std::pmr::polymorphic_allocator<Datum>(&arena));
+        // std::vector<d3_hexbin::pmr::HexbinBin<Datum, double>, std::pmr::polymorphic_allocator<...>>
+        @endcode
+
+        Temporary lookup structures of binning (O(bins)) are allocated from
+        global heap.
+     */
+    template <typename Allocator, typename = typename Allocator::value_type>
+    _bins_t<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>
+        operator () (const std::vector<T>& points, const Allocator& alloc) const
+    {
+        using item_alloc_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+        using bins_t = _bins_t<T, item_alloc_t>;
 
-} // namespace detail
+        _BinsSink<T, _PointAt, item_alloc_t> sink{*this, _PointAt{points}, bins_t(typename bins_t::allocator_type(alloc))};
+        _bin(points, sink);
+        return std::move(sink.bins);
+    }
 
-// Based on: https://github.com/DefinitelyTyped/DefinitelyTyped/blob/master/types/d3-hexbin/index.d.ts#L11
+    /**
+        Non-standart: multi-threaded operator(). Points are split between
+        `threads` threads (0 - std::thread::hardware_concurrency()). Result
+        is the same as of operator(), for any threads count. Accessors must
+        be safe to call concurrently.
+     */
+    std::vector<HexbinBin<T, number_t>> operator () (const std::vector<T>& points, unsigned threads) const
+    {
+        threads = detail::resolve_threads(threads);
+        return _bins<T>(_layout(points, threads), _PointAt{points}, threads);
+    }
 
-template <typename T, typename NumberT>
-struct HexbinBin : public std::vector<T>
-{
-    using number_t = NumberT;
+    /**
+        Non-standart: same as operator(), but bins are built in `workspace`,
+        which keeps tables & bins storage between calls (see
+        HexbinWorkspace). Returned reference is valid until next call with
+        the same workspace. `sort` engine is replaced by `hash` engine.
+     */
+    const std::vector<HexbinBin<T, number_t>>& operator () (const std::vector<T>& points, HexbinWorkspace<T, number_t>& workspace) const
+    {
+        if (_x || _y)
+            _bin(_PointsSource<component_func_t, component_func_t>{points, x(), y()}, points, workspace);
+        else
+            _bin(_PointsSource<XAccessor, YAccessor>{points, _x_accessor, _y_accessor}, points, workspace);
+        return workspace._bins;
+    }
 
     /**
-     * The x-coordinate of the center of the associated bin’s hexagon.
+        Non-standart: same as operator(), but bins are returned in
+        compressed-sparse-row form (see HexbinCsr). Points are split between
+        `threads` threads, like in multi-threaded operator().
      */
-    number_t x;
+    HexbinCsr<T, number_t> csr(const std::vector<T>& points, unsigned threads = 1) const
+    {
+        return _csr<T>(_layout(points, detail::resolve_threads(threads)), _PointAt{points});
+    }
 
     /**
-     * The y-coordinate of the center of the associated bin’s hexagon.
+        Non-standart: same as indices(), but bins are returned in
+        compressed-sparse-row form (see HexbinCsr).
      */
-    number_t y;
+    template <typename IndexT = std::size_t>
+    HexbinCsr<IndexT, number_t> csr_indices(const std::vector<T>& points, unsigned threads = 1) const
+    {
+        static_assert(std::is_integral<IndexT>::value, "IndexT must be integral type");
 
-    HexbinBin(const T& d)
-        : std::vector<T>{d}
-        , x(0)
-        , y(0)
-    {}
-};
+        return _csr<IndexT>(_layout(points, detail::resolve_threads(threads)), _IndexOf<IndexT>{});
+    }
 
-template <typename T, typename number_t, typename PointT = std::array<number_t, 2> >
-class Hexbin {
-public:
+    /**
+        Non-standart: same as operator(), but bins contain indices of points
+        in `points` instead of copies of points.
+     */
+    template <typename IndexT = std::size_t>
+    std::vector<HexbinBin<IndexT, number_t>> indices(const std::vector<T>& points) const
+    {
+        static_assert(std::is_integral<IndexT>::value, "IndexT must be integral type");
 
-    using component_func_t = std::function< number_t (const T& ) >;
+        _BinsSink<IndexT, _IndexOf<IndexT>> sink{*this, _IndexOf<IndexT>{}, {}};
+        _bin(points, sink);
+        return std::move(sink.bins);
+    }
 
-    using extent_t = std::array<PointT, 2>;
+    /**
+        Non-standart: multi-threaded indices() (see operator()(points, threads)).
+     */
+    template <typename IndexT = std::size_t>
+    std::vector<HexbinBin<IndexT, number_t>> indices(const std::vector<T>& points, unsigned threads) const
+    {
+        static_assert(std::is_integral<IndexT>::value, "IndexT must be integral type");
 
-private:
-    number_t x0 = 0;
-    number_t y0 = 0;
-    number_t x1 = 1;
-    number_t y1 = 1;
-    component_func_t _x = detail::pointX<T, number_t>;
-    component_func_t _y = detail::pointY<T, number_t>;
-    number_t r;
-    number_t dx;
-    number_t dy;
+        threads = detail::resolve_threads(threads);
+        return _bins<IndexT>(_layout(points, threads), _IndexOf<IndexT>{}, threads);
+    }
+
+    /**
+        Non-standart: same as operator(), but returns only bins centers and
+        points count per bin (memory usage is O(bins), not O(points)).
+     */
+    std::vector<HexbinCount<number_t>> counts(const std::vector<T>& points) const
+    {
+        _CountsSink sink{*this, {}};
+        _bin(points, sink);
+        return std::move(sink.bins);
+    }
 
     // -------------------------------------------------------------------------
-protected:
+    // Non-standart: structure-of-arrays input - points are given as x & y
+    // columns of length `n` (x & y accessors are not used). Column is pointer
+    // or any type with `operator[](std::size_t)`, returning number (like
+    // MappedColumn, see mapped.hpp).
 
-    // NOTICE: that this method returns RELATIVE coordinates (dx, dy),
-    // not absolute coords.
-    static std::array<PointT, 6> _hexagon(number_t radius) {
-        number_t x0 = 0, y0 = 0;
+    template <typename IndexT = std::size_t, typename XColumn, typename YColumn>
+    std::vector<HexbinBin<IndexT, number_t>> indices(const XColumn& xs, const YColumn& ys, std::size_t n) const
+    {
+        static_assert(std::is_integral<IndexT>::value, "IndexT must be integral type");
 
-        std::array<PointT, 6> result;
-        for(std::size_t i = 0; i < detail::angles.size(); ++i)
-        {
-            const auto& angle = detail::angles[i];
+        _BinsSink<IndexT, _IndexOf<IndexT>> sink{*this, _IndexOf<IndexT>{}, {}};
+        _bin(_ColumnsSource<XColumn, YColumn>{xs, ys, n}, sink);
+        return std::move(sink.bins);
+    }
 
-            const number_t
-                    x1 =  std::sin(angle) * radius,
-                    y1 = -std::cos(angle) * radius,
-                    dx = x1 - x0,
-                    dy = y1 - y0;
-            x0 = x1; y0 = y1;
-            result[i] = {dx, dy};
+    template <typename XColumn, typename YColumn>
+    std::vector<HexbinCount<number_t>> counts(const XColumn& xs, const YColumn& ys, std::size_t n) const
+    {
+        _CountsSink sink{*this, {}};
+        _bin(_ColumnsSource<XColumn, YColumn>{xs, ys, n}, sink);
+        return std::move(sink.bins);
+    }
+
+    /**
+        Non-standart: writes hexagon offset coordinates (pi, pj) of bins of
+        `n` points into `pi` & `pj` - the same, as used by operator(). Points
+        with NaN coordinate get `detail::invalid_cell`. For `double` number_t
+        uses SIMD kernel, if supported by CPU (see quantize.hpp).
+     */
+    template <typename ColumnT>
+    void quantize(const ColumnT* xs, const ColumnT* ys, std::size_t n, int* pi, int* pj) const
+    {
+        const _ColumnsSource<const ColumnT*, const ColumnT*> source{xs, ys, n};
+
+        number_t bxs[detail::block_size], bys[detail::block_size];
+        for (std::size_t base = 0; base < n; base += detail::block_size) {
+            const std::size_t count = std::min(detail::block_size, n - base);
+            source.load(base, count, bxs, bys);
+            detail::quantize(bxs, bys, count, dx, dy, pi + base, pj + base);
         }
-        return result;
     }
 
-    // -------------------------------------------------------------------------
-    // Utils (stringification)
+    void quantize(const number_t* xs, const number_t* ys, std::size_t n, int* pi, int* pj) const
+    {
+        detail::quantize(xs, ys, n, dx, dy, pi, pj);
+    }
 
-    template <typename ValueT>
-    static inline std::string _to_str(const ValueT& val) {
-        std::ostringstream out;
-        out << val;
-        return out.str();
+    /**
+        Non-standart: writes id of bin of each point into `out` (`points.size()`
+        items) without building bins - packed (pi, pj) offset coordinates of
+        bin hexagon (see `detail::pack_cell()`, `detail::cell_i()` &
+        `detail::cell_j()`), the same as HexbinAccumulator::ids(). Accessors,
+        clip() & quantization are the same, as in operator(). Points with NaN
+        coordinate (or outside of extent, if clip() is set) get `detail::no_cell`.
+     */
+    void bin_ids(const std::vector<T>& points, std::uint64_t* out) const
+    {
+        if (_x || _y)
+            _bin_ids(_PointsSource<component_func_t, component_func_t>{points, x(), y()}, out);
+        else
+            _bin_ids(_PointsSource<XAccessor, YAccessor>{points, _x_accessor, _y_accessor}, out);
     }
 
-    static inline std::string _p_to_str(const PointT& p) {
-        return _to_str(p[0]) + "," + _to_str(p[1]);
+    void bin_ids(const std::vector<T>& points, std::vector<std::uint64_t>& out) const
+    {
+        out.resize(points.size());
+        bin_ids(points, out.data());
     }
 
-    static inline std::string _join(const std::vector<std::string>& list, const std::string& delim) {
-        return std::accumulate(list.begin(), list.end(), std::string(), // via: https://stackoverflow.com/a/12155571
-                   [&delim](const std::string& a, const std::string& b) -> std::string {
-                       return a + (a.length() > 0 ? delim : "") + b;
-               });
+    /// Structure-of-arrays version of bin_ids() (x & y accessors are not used)
+    template <typename XColumn, typename YColumn>
+    void bin_ids(const XColumn& xs, const YColumn& ys, std::size_t n, std::uint64_t* out) const
+    {
+        _bin_ids(_ColumnsSource<XColumn, YColumn>{xs, ys, n}, out);
+    }
+
+    /**
+        Non-standart: same as operator(), but each point is fed directly into
+        fixed-size per-bin state of `aggregator` (see aggregate.hpp), without
+        storing points. Example:
+
+        @code{.cpp}
+        const auto bins = hexbin.aggregate(points, d3_hexbin::aggregate::stats(
+            [](const Datum& d) { return d.value; }));
+        // bins[i].value.mean, bins[i].value.variance, ...
+        @endcode
+     */
+    template <typename Aggregator>
+    std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>>
+        aggregate(const std::vector<T>& points, const Aggregator& aggregator = Aggregator()) const
+    {
+        _AggregateSink<Aggregator> sink{*this, points, aggregator, {}, {}};
+        _bin(points, sink);
+        return sink.finalize();
     }
 
     // -------------------------------------------------------------------------
+    // Non-standart: partial (mergeable) results of shards of points, see
+    // HexbinPartial (include "partial.hpp"). Indices of points are relative
+    // to shard.
 
-    static std::vector<std::string> _hexagon_str(number_t radius) {
-        std::vector<std::string> strings;
-        const auto points = _hexagon(radius);
-        for(const PointT& point : points) {
-            strings.push_back( _p_to_str(point) );
-        }
-        return strings;
+    template <typename Aggregator>
+    HexbinPartial<typename Aggregator::state_t>
+        partial(const std::vector<T>& points, const Aggregator& aggregator = Aggregator()) const
+    {
+        return _partial<typename Aggregator::state_t>(points, _AggregatePolicy<Aggregator>{points, aggregator});
     }
 
-public:
+    template <typename IndexT = std::size_t>
+    HexbinPartial<std::vector<IndexT>> partial_indices(const std::vector<T>& points) const
+    {
+        static_assert(std::is_integral<IndexT>::value, "IndexT must be integral type");
 
-    Hexbin()
+        return _partial<std::vector<IndexT>>(points, _IndexListPolicy<IndexT>{});
+    }
+
+    /**
+        Finalizes (merged) partial: same as aggregate() of concatenated shards.
+     */
+    template <typename Aggregator>
+    std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>>
+        aggregate(const HexbinPartial<typename Aggregator::state_t>& partial, const Aggregator& aggregator = Aggregator()) const
     {
-        radius(1);
+        std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>> bins;
+        bins.reserve(partial.size());
+        for (const std::size_t k : _partial_order(partial)) {
+            const int pi = detail::cell_i(partial.cells[k]), pj = detail::cell_j(partial.cells[k]);
+            bins.push_back({_center_x(pi, pj), _center_y(pj), aggregator.finalize(partial.states[k])});
+        }
+        return bins;
     }
 
+    /**
+        Finalizes (merged) partial of aggregate::count(): same as counts() of
+        concatenated shards.
+     */
+    std::vector<HexbinCount<number_t>> counts(const HexbinPartial<std::size_t>& partial) const
+    {
+        std::vector<HexbinCount<number_t>> bins;
+        bins.reserve(partial.size());
+        for (const std::size_t k : _partial_order(partial)) {
+            const int pi = detail::cell_i(partial.cells[k]), pj = detail::cell_j(partial.cells[k]);
+            bins.push_back({_center_x(pi, pj), _center_y(pj), partial.states[k]});
+        }
+        return bins;
+    }
 
-    std::vector<HexbinBin<T, number_t>> operator () (const std::vector<T>& points)
+    /**
+        Finalizes (merged) partial_indices(): same as indices() of
+        concatenated shards.
+     */
+    template <typename IndexT>
+    std::vector<HexbinBin<IndexT, number_t>> indices(const HexbinPartial<std::vector<IndexT>>& partial) const
     {
-        using bin_t = HexbinBin<T, number_t>;
+        std::vector<HexbinBin<IndexT, number_t>> bins;
+        bins.reserve(partial.size());
+        for (const std::size_t k : _partial_order(partial)) {
+            const int pi = detail::cell_i(partial.cells[k]), pj = detail::cell_j(partial.cells[k]);
+            const std::vector<IndexT>& indices = partial.states[k];
+            bins.emplace_back(indices.front());
+            _place(bins.back(), pi, pj);
+            bins.back().insert(bins.back().end(), indices.begin() + 1, indices.end());
+        }
+        return bins;
+    }
 
-        std::map<std::string, bin_t> binsById = {};
-        std::vector< bin_t > bins = {};
-        std::size_t i;
-        const std::size_t n = points.size();
+    // -------------------------------------------------------------------------
+    // Non-standart: multi-resolution pyramid
 
-        for (i = 0; i < n; ++i)
-        {
-            const T& point = points[i];
-
-            number_t px;
-            number_t py;
-            if (std::isnan(px = _x(point /*, i, points*/))
-             || std::isnan(py = _y(point /*, i, points*/))) continue;
-
-            int pj = std::round(py = py / dy);
-            int pi = std::round(px = (px / dx - (pj & 1) / 2.0) +0.00001); /// '2.0' instead of '2' for float division (non-integer), for same result as in js
-            const number_t py1 = py - pj;
-
-            if (std::abs(py1) * 3 > 1) {
-                const number_t
-                        px1 = px - pi,
-                        pi2 = pi + (px < pi ? -1 : 1) / 2,
-                        pj2 = pj + (py < pj ? -1 : 1),
-                        px2 = px - pi2,
-                        py2 = py - pj2;
-                if (px1 * px1 + py1 * py1 > px2 * px2 + py2 * py2) { pi = pi2 + (pj & 1 ? 1 : -1) / 2; pj = pj2; }
+    /**
+        Bins points once with current radius (level 0), then derives `levels - 1`
+        coarser levels (radius of level k is `radius() * factor^k`) from bins of
+        level 0: each fine bin is re-quantized by its center & its state is
+        merged into coarse bin (in O(fine bins) per level, without points).
+
+        Error bound: point is assigned to the coarse bin of its fine bin
+        center, which is within `radius()` from point - so only points within
+        `radius()` of coarse hexagons edges may be assigned to neighbour
+        coarse bin, and distance from any point to center of its coarse bin
+        is at most `radius() * factor^k + radius()` (instead of
+        `radius() * factor^k`). Points, which are exactly at fine bins centers,
+        are binned exactly.
+     */
+    template <typename Aggregator>
+    std::vector<std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>>>
+        pyramid(const std::vector<T>& points, std::size_t levels, number_t factor, const Aggregator& aggregator) const
+    {
+        std::vector<std::vector<HexbinAggregate<typename Aggregator::result_t, number_t>>> pyramid;
+        if (levels == 0) return pyramid;
+        pyramid.reserve(levels);
+
+        _AggregateSink<Aggregator> fine{*this, points, aggregator, {}, {}};
+        _bin(points, fine);
+        pyramid.push_back( fine.finalize() );
+
+        Hexbin coarse(*this);
+        detail::CellTable table;
+        for (std::size_t level = 1; level < levels; ++level) {
+            coarse.radius(coarse.r * factor);
+
+            _AggregateSink<Aggregator> sink{coarse, points, aggregator, {}, {}};
+            table.clear();
+            for (std::size_t k = 0; k < fine.cells.size(); ++k) {
+                const int fi = detail::cell_i(fine.cells[k]), fj = detail::cell_j(fine.cells[k]);
+
+                int pi, pj;
+                coarse._cell(_center_x(fi, fj), _center_y(fj), pi, pj);
+                const auto found = table.insert(pi, pj, static_cast<std::uint32_t>(sink.cells.size()));
+                if (found.second) {
+                    sink.cells.push_back( detail::pack_cell(pi, pj) );
+                    sink.states.push_back( fine.states[k] );
+                } else {
+                    aggregator.merge(sink.states[found.first], fine.states[k]);
+                }
             }
+            if (_order != HexbinOrder::first_seen)
+                sink.permute( coarse._ordering(sink.cells) );
 
-            const std::string id = _to_str(pi) + "-" + _to_str(pj);
-            const auto bin_it = binsById.find(id); // In js it's: `bin = binsById[id]`
-            if (bin_it != binsById.end()) // found
-                bin_it->second.push_back(point);
-            else { // not found
-
-                // In js next 3 lines of code it's: `bin = binsById[id] = [point];`
-                const auto result = binsById.insert({ id, bin_t(point) });
-                const auto bin_it_new = result.first;
-                bin_t& bin = (bin_it_new->second);
-
-                bin.x = (pi + (pj & 1) / 2.0) * dx; /// '2.0' instead '2' important here too
-                bin.y = pj * dy;
-                bins.push_back( bin );
-            }
+            pyramid.push_back( sink.finalize() );
         }
+        return pyramid;
+    }
 
-        // FIX for c++
-        bins.clear();
-        for(const auto& kv : binsById)
-            bins.push_back(kv.second);
+    /**
+        Same as pyramid(points, levels, factor, aggregator), but levels
+        contain bins counts (like counts()).
+     */
+    std::vector<std::vector<HexbinCount<number_t>>>
+        pyramid(const std::vector<T>& points, std::size_t levels, number_t factor = 2) const
+    {
+        const auto aggregates = pyramid(points, levels, factor, aggregate::count());
 
-        return bins;
+        std::vector<std::vector<HexbinCount<number_t>>> pyramid(aggregates.size());
+        for (std::size_t level = 0; level < aggregates.size(); ++level) {
+            pyramid[level].reserve(aggregates[level].size());
+            for (const auto& bin : aggregates[level])
+                pyramid[level].push_back({bin.x, bin.y, bin.value});
+        }
+        return pyramid;
     }
 
     // -------------------------------------------------------------------------
@@ -324,7 +2216,7 @@ public:
     }
 
     component_func_t x() const {
-        return _x;
+        return _x ? _x : component_func_t(_x_accessor);
     }
 
     // -------------------------------------------------------------------------
@@ -335,7 +2227,7 @@ public:
     }
 
     component_func_t y() const {
-        return _y;
+        return _y ? _y : component_func_t(_y_accessor);
     }
 
     // -------------------------------------------------------------------------
@@ -349,6 +2241,68 @@ public:
         return r;
     }
 
+    // -------------------------------------------------------------------------
+    // Non-standart: hexagon coordinates (see HexbinOffset, HexbinAxial &
+    // HexbinCube). Quantization is the same, as in operator().
+
+    /**
+        Returns offset coordinates of hexagon, containing point (px, py)
+        (accessors & clip() are not used). For NaN coordinate returns
+        (`detail::invalid_cell`, `detail::invalid_cell`).
+     */
+    HexbinOffset cell_of(number_t px, number_t py) const {
+        HexbinOffset cell;
+        detail::quantize(px, py, dx, dy, cell.i, cell.j);
+        return cell;
+    }
+
+    /// Returns center of hexagon (i, j) - the same, as `x` & `y` of its bin
+    PointT center_of(int i, int j) const {
+        return PointT{_center_x(i, j), _center_y(j)};
+    }
+
+    PointT center_of(const HexbinOffset& cell) const {
+        return center_of(cell.i, cell.j);
+    }
+
+    /// Returns center of hexagon of bin id (see bin_ids())
+    PointT center_of(std::uint64_t id) const {
+        return center_of(detail::cell_i(id), detail::cell_j(id));
+    }
+
+    /// Returns bin id (packed offset coordinates, see bin_ids()) of hexagon
+    static std::uint64_t id_of(const HexbinOffset& cell) {
+        return detail::pack_cell(cell.i, cell.j);
+    }
+
+    static HexbinOffset cell_of(std::uint64_t id) {
+        return {detail::cell_i(id), detail::cell_j(id)};
+    }
+
+    static HexbinAxial offset_to_axial(const HexbinOffset& cell) {
+        return {cell.i - (cell.j - (cell.j & 1)) / 2, cell.j};
+    }
+
+    static HexbinOffset axial_to_offset(const HexbinAxial& cell) {
+        return {cell.q + (cell.r - (cell.r & 1)) / 2, cell.r};
+    }
+
+    static HexbinCube axial_to_cube(const HexbinAxial& cell) {
+        return {cell.q, cell.r, -cell.q - cell.r};
+    }
+
+    static HexbinAxial cube_to_axial(const HexbinCube& cell) {
+        return {cell.x, cell.y};
+    }
+
+    static HexbinCube offset_to_cube(const HexbinOffset& cell) {
+        return axial_to_cube(offset_to_axial(cell));
+    }
+
+    static HexbinOffset cube_to_offset(const HexbinCube& cell) {
+        return axial_to_offset(cube_to_axial(cell));
+    }
+
     // -------------------------------------------------------------------------
 
     Hexbin& size(const PointT& size_) {
@@ -371,6 +2325,48 @@ public:
         return { PointT{x0, y0}, PointT{x1, y1} };
     }
 
+    // -------------------------------------------------------------------------
+    // Non-standart: bins order (not present in js, where bins always returned
+    // in order of first appearance)
+
+    Hexbin& order(HexbinOrder order_) {
+        _order = order_;
+        return *this;
+    }
+
+    HexbinOrder order() const {
+        return _order;
+    }
+
+    // -------------------------------------------------------------------------
+    // Non-standart: cells lookup engine & clipping by extent
+
+    /**
+        Selects cells lookup engine (see HexbinEngine). Dense grid is
+        allocated on every call of operator() - for repeated dense binning
+        pass HexbinWorkspace to operator().
+     */
+    Hexbin& engine(HexbinEngine engine_) {
+        _engine = engine_;
+        return *this;
+    }
+
+    HexbinEngine engine() const {
+        return _engine;
+    }
+
+    /**
+        If set, points out of extent() are skipped by operator().
+     */
+    Hexbin& clip(bool clip_) {
+        _clip = clip_;
+        return *this;
+    }
+
+    bool clip() const {
+        return _clip;
+    }
+
     // =========================================================================
     // Non-standart EXPERIMENTAL API for direct drawing by using something like
     // d3-path-cpp PathInterface API
@@ -454,6 +2450,21 @@ inline Hexbin<T, number_t, PointT> hexbin() {
     return Hexbin<T, number_t, PointT>();
 }
 
+/**
+    Non-standart: creates hexbin with compile-time accessor policies, for
+    example:
+
+    @code{.cpp}
+    auto b = d3_hexbin::hexbin<Datum, double>(
+        [](const Datum& d) { return d.lon; },
+        [](const Datum& d) { return d.lat; });
+    @endcode
+ */
+template <typename T, typename number_t, typename PointT = std::array<double, 2>, typename XAccessor, typename YAccessor>
+inline Hexbin<T, number_t, PointT, XAccessor, YAccessor> hexbin(const XAccessor& x, const YAccessor& y) {
+    return Hexbin<T, number_t, PointT, XAccessor, YAccessor>(x, y);
+}
+
 } // namespace d3_hexbin
 
 #endif // D3__HEXBIN__HEXBIN_HPP
@@ -0,0 +1,162 @@
+#ifndef D3__HEXBIN__MAPPED_HPP
+#define D3__HEXBIN__MAPPED_HPP
+
+#include <cstddef>  // for std::size_t
+#include <cstdint>  // for std::uint8_t
+#include <cstring>  // for std::memcpy()
+#include <string>   // for std::string
+#include <utility>  // for std::swap()
+#include <algorithm> // for std::reverse()
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>    // for open()
+#include <unistd.h>   // for close()
+#include <sys/mman.h> // for mmap(), madvise(), munmap()
+#include <sys/stat.h> // for fstat()
+#else
+#error "mapped.hpp requires POSIX mmap()"
+#endif
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: records layout of binary points file. Each record is
+    `stride` bytes long and contains little-endian x & y values at
+    `x_offset` & `y_offset` bytes. First `header` bytes of file are skipped,
+    trailing incomplete record is ignored.
+ */
+struct MappedLayout
+{
+    std::size_t stride;
+    std::size_t x_offset;
+    std::size_t y_offset;
+    std::size_t header;
+
+    /// Layout of plain (x, y) pairs of ValueT
+    template <typename ValueT>
+    static MappedLayout pairs() {
+        return {2 * sizeof(ValueT), 0, sizeof(ValueT), 0};
+    }
+};
+
+/**
+    Non-standart: column of mapped records - values are read in place
+    (unaligned, little-endian), by `operator[]`.
+ */
+template <typename ValueT>
+struct MappedColumn
+{
+    const std::uint8_t* data;
+    std::size_t         stride;
+
+    ValueT operator [] (std::size_t index) const {
+        ValueT value;
+        std::memcpy(&value, data + index * stride, sizeof(ValueT));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        std::uint8_t* bytes = reinterpret_cast<std::uint8_t*>(&value);
+        std::reverse(bytes, bytes + sizeof(ValueT));
+#endif
+        return value;
+    }
+};
+
+/**
+    Non-standart: read-only memory-mapped binary points file, for binning of
+    files, larger than memory, without loading them into `std::vector<T>`.
+    File is mapped with `MADV_SEQUENTIAL` hint (pages are read ahead and may
+    be evicted after binning passes them). Columns are passed to
+    structure-of-arrays Hexbin::counts() & Hexbin::indices():
+
+    @code{.cpp}
+    d3_hexbin::MappedPoints<float> file("points.bin"); // (x, y) float pairs
+    if (file.is_open()) {
+        const auto bins = hexbin.counts(file.xs(), file.ys(), file.size());
+    }
+
+    // records of (id: u32, x: f64, y: f64, value: f64)
+    d3_hexbin::MappedPoints<double> records("records.bin", {28, 4, 12, 0});
+    @endcode
+ */
+template <typename ValueT>
+class MappedPoints
+{
+    const std::uint8_t* _data = nullptr;
+    std::size_t         _bytes = 0;
+    std::size_t         _size = 0;
+    MappedLayout        _layout;
+
+public:
+
+    explicit MappedPoints(const std::string& path, const MappedLayout& layout = MappedLayout::pairs<ValueT>())
+        : _layout(layout)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                ::madvise(data, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+                _data  = static_cast<const std::uint8_t*>(data);
+                _bytes = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd); // mapping keeps file referenced
+
+        const std::size_t last = std::max(_layout.x_offset, _layout.y_offset) + sizeof(ValueT);
+        if (_data && _layout.stride >= last && _bytes >= _layout.header)
+            _size = (_bytes - _layout.header) / _layout.stride;
+    }
+
+    MappedPoints(const MappedPoints&) = delete;
+    MappedPoints& operator = (const MappedPoints&) = delete;
+
+    MappedPoints(MappedPoints&& other)
+        : _layout(other._layout)
+    {
+        swap(other);
+    }
+
+    MappedPoints& operator = (MappedPoints&& other) {
+        swap(other);
+        return *this;
+    }
+
+    ~MappedPoints() {
+        if (_data) ::munmap(const_cast<std::uint8_t*>(_data), _bytes);
+    }
+
+    void swap(MappedPoints& other) {
+        std::swap(_data,   other._data);
+        std::swap(_bytes,  other._bytes);
+        std::swap(_size,   other._size);
+        std::swap(_layout, other._layout);
+    }
+
+    /// Returns false, if file can't be opened or mapped (or is empty)
+    bool is_open() const {
+        return _data != nullptr;
+    }
+
+    /// Returns records count
+    std::size_t size() const {
+        return _size;
+    }
+
+    const MappedLayout& layout() const {
+        return _layout;
+    }
+
+    MappedColumn<ValueT> xs() const {
+        return {_data + _layout.header + _layout.x_offset, _layout.stride};
+    }
+
+    MappedColumn<ValueT> ys() const {
+        return {_data + _layout.header + _layout.y_offset, _layout.stride};
+    }
+};
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__MAPPED_HPP
@@ -0,0 +1,270 @@
+#ifndef D3__HEXBIN__PARTIAL_HPP
+#define D3__HEXBIN__PARTIAL_HPP
+
+#include "hexbin.hpp"
+
+#include <cstring> // for std::memcpy()
+
+namespace d3_hexbin {
+
+namespace detail {
+
+/**
+    Merge-join of partials of consecutive shards `a` & `b`. States of bins,
+    present only in `b`, are converted by `shift(state)`, states of common
+    bins are merged by `merge(state, other)`.
+ */
+template <typename StateT, typename Shift, typename Merge>
+inline HexbinPartial<StateT> merge_partials(const HexbinPartial<StateT>& a, const HexbinPartial<StateT>& b,
+                                            const Shift& shift, const Merge& merge)
+{
+    HexbinPartial<StateT> result;
+    result.points = a.points + b.points;
+    result.cells.reserve(a.size() + b.size());
+    result.firsts.reserve(a.size() + b.size());
+    result.states.reserve(a.size() + b.size());
+
+    std::size_t ia = 0, ib = 0;
+    while (ia < a.size() || ib < b.size()) {
+        const std::uint64_t ka = (ia < a.size()) ? pack_sortable_cell(cell_i(a.cells[ia]), cell_j(a.cells[ia])) : ~0ULL;
+        const std::uint64_t kb = (ib < b.size()) ? pack_sortable_cell(cell_i(b.cells[ib]), cell_j(b.cells[ib])) : ~0ULL;
+        if (ib == b.size() || (ia < a.size() && ka < kb)) {
+            result.cells.push_back(a.cells[ia]);
+            result.firsts.push_back(a.firsts[ia]);
+            result.states.push_back(a.states[ia]);
+            ++ia;
+        } else if (ia == a.size() || kb < ka) {
+            result.cells.push_back(b.cells[ib]);
+            result.firsts.push_back(a.points + b.firsts[ib]);
+            result.states.push_back( shift(b.states[ib]) );
+            ++ib;
+        } else {
+            result.cells.push_back(a.cells[ia]);
+            result.firsts.push_back(a.firsts[ia]);
+            result.states.push_back(a.states[ia]);
+            merge(result.states.back(), shift(b.states[ib]));
+            ++ia;
+            ++ib;
+        }
+    }
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Binary encoding
+
+enum : std::uint8_t {
+    partial_version    = 2,
+    partial_raw_states = 0,
+    partial_index_list = 1,
+    partial_little     = 0,
+    partial_big        = 1
+};
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+const std::uint8_t partial_host_order = partial_big;
+#else
+const std::uint8_t partial_host_order = partial_little;
+#endif
+
+inline void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back( static_cast<std::uint8_t>(v | 0x80) );
+        v >>= 7;
+    }
+    out.push_back( static_cast<std::uint8_t>(v) );
+}
+
+inline bool get_varint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (data == end) return false;
+        const std::uint8_t byte = *data++;
+        v |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// Trivially copyable states are stored as raw bytes (in host representation,
+// so byte order is part of header)
+template <typename StateT>
+struct PartialCodec
+{
+    static_assert(std::is_trivially_copyable<StateT>::value,
+                  "state must be trivially copyable (or list of indices) to be encoded");
+
+    static const std::uint8_t  kind  = partial_raw_states;
+    static const std::uint8_t  order = partial_host_order;
+    static const std::uint16_t item = sizeof(StateT);
+
+    static void put(std::vector<std::uint8_t>& out, const StateT& state) {
+        const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(&state);
+        out.insert(out.end(), bytes, bytes + sizeof(StateT));
+    }
+
+    static bool get(const std::uint8_t*& data, const std::uint8_t* end, StateT& state) {
+        if (static_cast<std::size_t>(end - data) < sizeof(StateT)) return false;
+        std::memcpy(&state, data, sizeof(StateT));
+        data += sizeof(StateT);
+        return true;
+    }
+};
+
+// Indices lists are stored as varint count & varint deltas of ascending indices
+// (varints are little-endian on any host)
+template <typename IndexT>
+struct PartialCodec<std::vector<IndexT>>
+{
+    static const std::uint8_t  kind  = partial_index_list;
+    static const std::uint8_t  order = partial_little;
+    static const std::uint16_t item = sizeof(IndexT);
+
+    static void put(std::vector<std::uint8_t>& out, const std::vector<IndexT>& indices) {
+        put_varint(out, indices.size());
+        std::uint64_t prev = 0;
+        for (const IndexT index : indices) {
+            put_varint(out, static_cast<std::uint64_t>(index) - prev);
+            prev = static_cast<std::uint64_t>(index);
+        }
+    }
+
+    static bool get(const std::uint8_t*& data, const std::uint8_t* end, std::vector<IndexT>& indices) {
+        std::uint64_t count = 0, index = 0, delta = 0;
+        if (!get_varint(data, end, count) || count > static_cast<std::uint64_t>(end - data)) return false;
+        indices.resize(count);
+        for (IndexT& i : indices) {
+            if (!get_varint(data, end, delta)) return false;
+            index += delta;
+            i = static_cast<IndexT>(index);
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+
+/**
+    Merges partials of consecutive shards `a` & `b` (`b` follows `a`) in
+    O(bins) - aggregator states of common bins are merged by `aggregator`.
+ */
+template <typename StateT, typename Aggregator>
+inline HexbinPartial<StateT> merge(const HexbinPartial<StateT>& a, const HexbinPartial<StateT>& b,
+                                   const Aggregator& aggregator)
+{
+    return detail::merge_partials(a, b,
+        [](const StateT& state) { return state; },
+        [&aggregator](StateT& state, const StateT& other) { aggregator.merge(state, other); });
+}
+
+/**
+    Merges partials of consecutive shards `a` & `b` (`b` follows `a`) in
+    O(bins + indices) - indices of `b` are shifted by `a.points`.
+ */
+template <typename IndexT>
+inline HexbinPartial<std::vector<IndexT>> merge(const HexbinPartial<std::vector<IndexT>>& a,
+                                                const HexbinPartial<std::vector<IndexT>>& b)
+{
+    const IndexT offset = static_cast<IndexT>(a.points);
+    return detail::merge_partials(a, b,
+        [offset](const std::vector<IndexT>& indices) {
+            std::vector<IndexT> shifted(indices);
+            for (IndexT& i : shifted) i += offset;
+            return shifted;
+        },
+        [](std::vector<IndexT>& indices, const std::vector<IndexT>& other) {
+            indices.insert(indices.end(), other.begin(), other.end());
+        });
+}
+
+/**
+    Encodes partial into compact binary form:
+
+    @code
+    "HXBP", u8 version, u8 state kind (0 - raw states, 1 - indices lists),
+    u8 byte order (0 - little-endian, 1 - big-endian), u16 LE state/index size,
+    varint points, varint bins,
+    bins: varint (by_cell key delta), varint first, state
+    @endcode
+
+    Raw states are stored in host representation, so encoder & decoder must
+    share state layout (checked by size & byte order only).
+ */
+template <typename StateT>
+inline std::vector<std::uint8_t> encode(const HexbinPartial<StateT>& partial)
+{
+    using codec = detail::PartialCodec<StateT>;
+
+    std::vector<std::uint8_t> out = {'H', 'X', 'B', 'P', detail::partial_version, codec::kind, codec::order,
+                                     static_cast<std::uint8_t>(codec::item & 0xFF),
+                                     static_cast<std::uint8_t>(codec::item >> 8)};
+    detail::put_varint(out, partial.points);
+    detail::put_varint(out, partial.size());
+
+    std::uint64_t prev = 0;
+    for (std::size_t k = 0; k < partial.size(); ++k) {
+        const std::uint64_t key = detail::pack_sortable_cell(detail::cell_i(partial.cells[k]),
+                                                             detail::cell_j(partial.cells[k]));
+        detail::put_varint(out, key - prev);
+        detail::put_varint(out, partial.firsts[k]);
+        codec::put(out, partial.states[k]);
+        prev = key;
+    }
+    return out;
+}
+
+/**
+    Decodes partial, encoded by encode(). Returns false (and leaves
+    `partial` unspecified), if data is malformed (including keys, not
+    strictly ascending or out of range), of other version, of other state
+    type or of other byte order.
+ */
+template <typename StateT>
+inline bool decode(const std::uint8_t* data, std::size_t size, HexbinPartial<StateT>& partial)
+{
+    using codec = detail::PartialCodec<StateT>;
+
+    const std::uint8_t* end = data + size;
+    if (size < 9 || std::memcmp(data, "HXBP", 4) != 0
+                 || data[4] != detail::partial_version
+                 || data[5] != codec::kind
+                 || data[6] != codec::order
+                 || (data[7] | (data[8] << 8)) != codec::item) {
+        return false;
+    }
+    data += 9;
+
+    std::uint64_t bins = 0;
+    if (!detail::get_varint(data, end, partial.points) ||
+        !detail::get_varint(data, end, bins) || bins > static_cast<std::uint64_t>(end - data)) {
+        return false;
+    }
+
+    partial.cells.resize(bins);
+    partial.firsts.resize(bins);
+    partial.states.resize(bins);
+
+    std::uint64_t key = 0, delta = 0;
+    for (std::size_t k = 0; k < bins; ++k) {
+        if (!detail::get_varint(data, end, delta) ||
+            !detail::get_varint(data, end, partial.firsts[k]) ||
+            !codec::get(data, end, partial.states[k])) {
+            return false;
+        }
+        if ((k > 0 && delta == 0) || key + delta < key) return false;
+        key += delta;
+        partial.cells[k] = detail::sortable_to_cell(key);
+    }
+    return data == end;
+}
+
+template <typename StateT>
+inline bool decode(const std::vector<std::uint8_t>& bytes, HexbinPartial<StateT>& partial) {
+    return decode(bytes.data(), bytes.size(), partial);
+}
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__PARTIAL_HPP
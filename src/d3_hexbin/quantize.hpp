@@ -0,0 +1,322 @@
+#ifndef D3__HEXBIN__QUANTIZE_HPP
+#define D3__HEXBIN__QUANTIZE_HPP
+
+#include <cmath>   // for std::round(), std::abs(), std::isnan()
+#include <cstddef> // for std::size_t
+#include <limits>  // for std::numeric_limits<T>::...
+
+/*
+    SIMD kernels (SSE4.1 / AVX2 / AVX-512F) for `double` coordinates, chosen
+    at runtime by CPU dispatch. Enabled for GCC & Clang on x86; define
+    D3_HEXBIN_NO_SIMD to use only scalar code.
+
+    NOTICE: kernels produce the same cells as scalar code, if scalar code is
+    compiled without FP contraction into FMA (default for x86-64 without
+    -mfma; otherwise add -ffp-contract=off).
+*/
+#if !defined(D3_HEXBIN_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define D3_HEXBIN_SIMD_X86 1
+    #include <immintrin.h>
+    #define D3_HEXBIN_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace d3_hexbin {
+
+namespace detail {
+
+// -----------------------------------------------------------------------------
+// Point -> hexagon offset coordinates (pi, pj)
+
+/**
+    Coordinate, returned for points with NaN coordinate (such points are
+    skipped by binning).
+ */
+constexpr int invalid_cell = std::numeric_limits<int>::min();
+
+/**
+    Quantizes point (px, py) into hexagon offset coordinates (pi, pj), for
+    hexagons with horizontal step `dx` and vertical step `dy`. Points with NaN
+    coordinate are quantized into (invalid_cell, invalid_cell).
+
+    This is the same math as in original d3-hexbin binning loop, written
+    without branches on data, so loops over it may be auto-vectorized.
+ */
+template <typename number_t>
+inline void quantize(number_t px, number_t py, number_t dx, number_t dy, int& pi, int& pj)
+{
+    const bool valid = !(std::isnan(px) || std::isnan(py));
+    px = valid ? px : 0;
+    py = valid ? py : 0;
+
+    const int j = std::round(py = py / dy);
+    const int i = std::round(px = (px / dx - (j & 1) / 2.0) +0.00001); /// '2.0' instead of '2' for float division (non-integer), for same result as in js
+    const number_t py1 = py - j;
+
+    const number_t
+            px1 = px - i,
+            pi2 = i + (px < i ? -1 : 1) / 2,
+            pj2 = j + (py < j ? -1 : 1),
+            px2 = px - pi2,
+            py2 = py - pj2;
+    const bool swap = (std::abs(py1) * 3 > 1) & (px1 * px1 + py1 * py1 > px2 * px2 + py2 * py2);
+
+    pi = valid ? (swap ? static_cast<int>(pi2 + (j & 1 ? 1 : -1) / 2) : i) : invalid_cell;
+    pj = valid ? (swap ? static_cast<int>(pj2) : j) : invalid_cell;
+}
+
+/**
+    Quantizes `n` points, given as separate x & y columns.
+ */
+template <typename number_t>
+inline void quantize_scalar(const number_t* xs, const number_t* ys, std::size_t n, number_t dx, number_t dy, int* pi, int* pj)
+{
+    for (std::size_t k = 0; k < n; ++k)
+        quantize(xs[k], ys[k], dx, dy, pi[k], pj[k]);
+}
+
+// -----------------------------------------------------------------------------
+// SIMD kernels
+
+enum class QuantizeKernel
+{
+    scalar,
+    sse41,
+    avx2,
+    avx512
+};
+
+#if defined(D3_HEXBIN_SIMD_X86)
+
+/*
+    Each kernel is the same as scalar quantize(), lane by lane:
+        - std::round() (half away from zero) is `t + (|v - t| >= 0.5 ? sign(v) : 0)`,
+          where t = trunc(v) (`v - t` is exact)
+        - in scalar code `pi2 == pi` (integer division), so `pi` never changes
+          and `px2 == px1`
+        - invalid (NaN) lanes are computed on zeros & replaced by invalid_cell
+*/
+
+D3_HEXBIN_TARGET("sse4.1")
+inline void quantize2_sse41(const double* xs, const double* ys, double dx, double dy, int* pi, int* pj)
+{
+    const __m128d sign = _mm_set1_pd(-0.0), one = _mm_set1_pd(1.0), half = _mm_set1_pd(0.5);
+    const __m128d invalid = _mm_set1_pd(invalid_cell);
+
+    __m128d x = _mm_loadu_pd(xs), y = _mm_loadu_pd(ys);
+    const __m128d valid = _mm_and_pd(_mm_cmpord_pd(x, x), _mm_cmpord_pd(y, y));
+    x = _mm_and_pd(x, valid);
+    y = _mm_and_pd(y, valid);
+
+    const __m128d py = _mm_div_pd(y, _mm_set1_pd(dy));
+    __m128d t = _mm_round_pd(py, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m128d rj = _mm_add_pd(t, _mm_and_pd(_mm_cmpge_pd(_mm_andnot_pd(sign, _mm_sub_pd(py, t)), half), _mm_or_pd(_mm_and_pd(py, sign), one)));
+
+    const __m128i j = _mm_cvttpd_epi32(rj);
+    const __m128d odd = _mm_mul_pd(_mm_cvtepi32_pd(_mm_and_si128(j, _mm_set1_epi32(1))), half);
+    const __m128d px = _mm_add_pd(_mm_sub_pd(_mm_div_pd(x, _mm_set1_pd(dx)), odd), _mm_set1_pd(0.00001));
+    t = _mm_round_pd(px, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m128d ri = _mm_add_pd(t, _mm_and_pd(_mm_cmpge_pd(_mm_andnot_pd(sign, _mm_sub_pd(px, t)), half), _mm_or_pd(_mm_and_pd(px, sign), one)));
+
+    const __m128d py1 = _mm_sub_pd(py, rj);
+    const __m128d px1 = _mm_sub_pd(px, ri);
+    const __m128d pj2 = _mm_add_pd(rj, _mm_blendv_pd(one, _mm_set1_pd(-1.0), _mm_cmplt_pd(py, rj)));
+    const __m128d py2 = _mm_sub_pd(py, pj2);
+    const __m128d far = _mm_cmpgt_pd(_mm_mul_pd(_mm_andnot_pd(sign, py1), _mm_set1_pd(3.0)), one);
+    const __m128d closer = _mm_cmpgt_pd(_mm_add_pd(_mm_mul_pd(px1, px1), _mm_mul_pd(py1, py1)),
+                                        _mm_add_pd(_mm_mul_pd(px1, px1), _mm_mul_pd(py2, py2)));
+    const __m128d oj = _mm_blendv_pd(invalid, _mm_blendv_pd(rj, pj2, _mm_and_pd(far, closer)), valid);
+    const __m128d oi = _mm_blendv_pd(invalid, ri, valid);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pi), _mm_cvttpd_epi32(oi));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pj), _mm_cvttpd_epi32(oj));
+}
+
+D3_HEXBIN_TARGET("sse4.1")
+inline void quantize_sse41(const double* xs, const double* ys, std::size_t n, double dx, double dy, int* pi, int* pj)
+{
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        quantize2_sse41(xs + k,     ys + k,     dx, dy, pi + k,     pj + k);
+        quantize2_sse41(xs + k + 2, ys + k + 2, dx, dy, pi + k + 2, pj + k + 2);
+        quantize2_sse41(xs + k + 4, ys + k + 4, dx, dy, pi + k + 4, pj + k + 4);
+        quantize2_sse41(xs + k + 6, ys + k + 6, dx, dy, pi + k + 6, pj + k + 6);
+    }
+    quantize_scalar(xs + k, ys + k, n - k, dx, dy, pi + k, pj + k);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+D3_HEXBIN_TARGET("avx2")
+inline void quantize4_avx2(const double* xs, const double* ys, double dx, double dy, int* pi, int* pj)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0), one = _mm256_set1_pd(1.0), half = _mm256_set1_pd(0.5);
+    const __m256d invalid = _mm256_set1_pd(invalid_cell);
+
+    __m256d x = _mm256_loadu_pd(xs), y = _mm256_loadu_pd(ys);
+    const __m256d valid = _mm256_and_pd(_mm256_cmp_pd(x, x, _CMP_ORD_Q), _mm256_cmp_pd(y, y, _CMP_ORD_Q));
+    x = _mm256_and_pd(x, valid);
+    y = _mm256_and_pd(y, valid);
+
+    const __m256d py = _mm256_div_pd(y, _mm256_set1_pd(dy));
+    __m256d t = _mm256_round_pd(py, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d rj = _mm256_add_pd(t, _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(py, t)), half, _CMP_GE_OQ), _mm256_or_pd(_mm256_and_pd(py, sign), one)));
+
+    const __m128i j = _mm256_cvttpd_epi32(rj);
+    const __m256d odd = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_and_si128(j, _mm_set1_epi32(1))), half);
+    const __m256d px = _mm256_add_pd(_mm256_sub_pd(_mm256_div_pd(x, _mm256_set1_pd(dx)), odd), _mm256_set1_pd(0.00001));
+    t = _mm256_round_pd(px, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d ri = _mm256_add_pd(t, _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(px, t)), half, _CMP_GE_OQ), _mm256_or_pd(_mm256_and_pd(px, sign), one)));
+
+    const __m256d py1 = _mm256_sub_pd(py, rj);
+    const __m256d px1 = _mm256_sub_pd(px, ri);
+    const __m256d pj2 = _mm256_add_pd(rj, _mm256_blendv_pd(one, _mm256_set1_pd(-1.0), _mm256_cmp_pd(py, rj, _CMP_LT_OQ)));
+    const __m256d py2 = _mm256_sub_pd(py, pj2);
+    const __m256d far = _mm256_cmp_pd(_mm256_mul_pd(_mm256_andnot_pd(sign, py1), _mm256_set1_pd(3.0)), one, _CMP_GT_OQ);
+    const __m256d closer = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(px1, px1), _mm256_mul_pd(py1, py1)),
+                                         _mm256_add_pd(_mm256_mul_pd(px1, px1), _mm256_mul_pd(py2, py2)), _CMP_GT_OQ);
+    const __m256d oj = _mm256_blendv_pd(invalid, _mm256_blendv_pd(rj, pj2, _mm256_and_pd(far, closer)), valid);
+    const __m256d oi = _mm256_blendv_pd(invalid, ri, valid);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pi), _mm256_cvttpd_epi32(oi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pj), _mm256_cvttpd_epi32(oj));
+}
+
+D3_HEXBIN_TARGET("avx2")
+inline void quantize_avx2(const double* xs, const double* ys, std::size_t n, double dx, double dy, int* pi, int* pj)
+{
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        quantize4_avx2(xs + k,     ys + k,     dx, dy, pi + k,     pj + k);
+        quantize4_avx2(xs + k + 4, ys + k + 4, dx, dy, pi + k + 4, pj + k + 4);
+    }
+    quantize_scalar(xs + k, ys + k, n - k, dx, dy, pi + k, pj + k);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+// NOTICE: AVX-512F implies FMA, so `*_round_pd` intrinsics with explicit
+// rounding are used here for mul/add - the compiler never fuses them.
+// `maskz` forms (with all lanes set) avoid false -Wmaybe-uninitialized
+// warnings from GCC headers.
+#define D3_HEXBIN_RN (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+
+D3_HEXBIN_TARGET("avx512f")
+inline void quantize8_avx512(const double* xs, const double* ys, double dx, double dy, int* pi, int* pj)
+{
+    const __m512d one = _mm512_set1_pd(1.0), half = _mm512_set1_pd(0.5);
+    const __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL));
+    const __m512d invalid = _mm512_set1_pd(invalid_cell);
+    const __mmask8 all = 0xFF;
+
+    __m512d x = _mm512_loadu_pd(xs), y = _mm512_loadu_pd(ys);
+    const __mmask8 valid = _mm512_cmp_pd_mask(x, x, _CMP_ORD_Q) & _mm512_cmp_pd_mask(y, y, _CMP_ORD_Q);
+    x = _mm512_maskz_mov_pd(valid, x);
+    y = _mm512_maskz_mov_pd(valid, y);
+
+    const __m512d py = _mm512_maskz_div_round_pd(all, y, _mm512_set1_pd(dy), D3_HEXBIN_RN);
+    __m512d t = _mm512_maskz_roundscale_pd(all, py, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m512d sgn = _mm512_castsi512_pd(_mm512_or_epi64(_mm512_and_epi64(_mm512_castpd_si512(py), sign), _mm512_castpd_si512(one)));
+    const __m512d rj = _mm512_mask_add_pd(t, _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_maskz_sub_round_pd(all, py, t, D3_HEXBIN_RN)), half, _CMP_GE_OQ), t, sgn);
+
+    const __m256i j = _mm512_maskz_cvttpd_epi32(all, rj);
+    const __m512d odd = _mm512_maskz_mul_round_pd(all, _mm512_maskz_cvtepi32_pd(all, _mm256_and_si256(j, _mm256_set1_epi32(1))), half, D3_HEXBIN_RN);
+    const __m512d px = _mm512_maskz_add_round_pd(all, _mm512_maskz_sub_round_pd(all, _mm512_maskz_div_round_pd(all, x, _mm512_set1_pd(dx), D3_HEXBIN_RN), odd, D3_HEXBIN_RN), _mm512_set1_pd(0.00001), D3_HEXBIN_RN);
+    t = _mm512_maskz_roundscale_pd(all, px, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    sgn = _mm512_castsi512_pd(_mm512_or_epi64(_mm512_and_epi64(_mm512_castpd_si512(px), sign), _mm512_castpd_si512(one)));
+    const __m512d ri = _mm512_mask_add_pd(t, _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_maskz_sub_round_pd(all, px, t, D3_HEXBIN_RN)), half, _CMP_GE_OQ), t, sgn);
+
+    const __m512d py1 = _mm512_maskz_sub_round_pd(all, py, rj, D3_HEXBIN_RN);
+    const __m512d px1 = _mm512_maskz_sub_round_pd(all, px, ri, D3_HEXBIN_RN);
+    const __m512d pj2 = _mm512_maskz_add_round_pd(all, rj, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(py, rj, _CMP_LT_OQ), one, _mm512_set1_pd(-1.0)), D3_HEXBIN_RN);
+    const __m512d py2 = _mm512_maskz_sub_round_pd(all, py, pj2, D3_HEXBIN_RN);
+    const __m512d px1s = _mm512_maskz_mul_round_pd(all, px1, px1, D3_HEXBIN_RN);
+    const __mmask8 far = _mm512_cmp_pd_mask(_mm512_maskz_mul_round_pd(all, _mm512_abs_pd(py1), _mm512_set1_pd(3.0), D3_HEXBIN_RN), one, _CMP_GT_OQ);
+    const __mmask8 closer = _mm512_cmp_pd_mask(_mm512_maskz_add_round_pd(all, px1s, _mm512_maskz_mul_round_pd(all, py1, py1, D3_HEXBIN_RN), D3_HEXBIN_RN),
+                                               _mm512_maskz_add_round_pd(all, px1s, _mm512_maskz_mul_round_pd(all, py2, py2, D3_HEXBIN_RN), D3_HEXBIN_RN), _CMP_GT_OQ);
+    const __m512d oj = _mm512_mask_blend_pd(valid, invalid, _mm512_mask_blend_pd(far & closer, rj, pj2));
+    const __m512d oi = _mm512_mask_blend_pd(valid, invalid, ri);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pi), _mm512_maskz_cvttpd_epi32(all, oi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pj), _mm512_maskz_cvttpd_epi32(all, oj));
+}
+
+#undef D3_HEXBIN_RN
+
+D3_HEXBIN_TARGET("avx512f")
+inline void quantize_avx512(const double* xs, const double* ys, std::size_t n, double dx, double dy, int* pi, int* pj)
+{
+    std::size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        quantize8_avx512(xs + k,     ys + k,     dx, dy, pi + k,     pj + k);
+        quantize8_avx512(xs + k + 8, ys + k + 8, dx, dy, pi + k + 8, pj + k + 8);
+    }
+    quantize_scalar(xs + k, ys + k, n - k, dx, dy, pi + k, pj + k);
+}
+
+inline QuantizeKernel detect_quantize_kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return QuantizeKernel::avx512;
+    if (__builtin_cpu_supports("avx2"))    return QuantizeKernel::avx2;
+    if (__builtin_cpu_supports("sse4.1"))  return QuantizeKernel::sse41;
+    return QuantizeKernel::scalar;
+}
+
+#else
+
+inline QuantizeKernel detect_quantize_kernel() {
+    return QuantizeKernel::scalar;
+}
+
+#endif // D3_HEXBIN_SIMD_X86
+
+/**
+    Best kernel, supported by current CPU (detected once).
+ */
+inline QuantizeKernel quantize_kernel() {
+    static const QuantizeKernel kernel = detect_quantize_kernel();
+    return kernel;
+}
+
+/**
+    Returns false (and does nothing), if `kernel` not supported by current
+    CPU or build.
+ */
+inline bool quantize(QuantizeKernel kernel, const double* xs, const double* ys, std::size_t n, double dx, double dy, int* pi, int* pj)
+{
+    if (kernel > quantize_kernel()) return false;
+
+    switch (kernel) {
+#if defined(D3_HEXBIN_SIMD_X86)
+    case QuantizeKernel::avx512: quantize_avx512(xs, ys, n, dx, dy, pi, pj); break;
+    case QuantizeKernel::avx2:   quantize_avx2  (xs, ys, n, dx, dy, pi, pj); break;
+    case QuantizeKernel::sse41:  quantize_sse41 (xs, ys, n, dx, dy, pi, pj); break;
+#endif
+    default:                     quantize_scalar(xs, ys, n, dx, dy, pi, pj); break;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+/**
+    Quantizes `n` points, given as separate x & y columns, by best available
+    kernel.
+ */
+template <typename number_t>
+inline void quantize(const number_t* xs, const number_t* ys, std::size_t n, number_t dx, number_t dy, int* pi, int* pj)
+{
+    quantize_scalar(xs, ys, n, dx, dy, pi, pj);
+}
+
+inline void quantize(const double* xs, const double* ys, std::size_t n, double dx, double dy, int* pi, int* pj)
+{
+    quantize(quantize_kernel(), xs, ys, n, dx, dy, pi, pj);
+}
+
+// -----------------------------------------------------------------------------
+
+} // namespace detail
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__QUANTIZE_HPP
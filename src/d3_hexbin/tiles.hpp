@@ -0,0 +1,251 @@
+#ifndef D3__HEXBIN__TILES_HPP
+#define D3__HEXBIN__TILES_HPP
+
+#include "hexbin.hpp"
+
+#include <list>          // for std::list<T>
+#include <unordered_map> // for std::unordered_map<K, V>
+#include <memory>        // for std::shared_ptr<T>
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: hexbinning of slippy-map (z/x/y, Web Mercator) tiles.
+
+    Points are given as longitude & latitude (degrees). Tile is binned in
+    global pixel coordinates of its zoom level, so hexagons grid is anchored
+    at world origin and stays aligned across tiles seams. Only points inside
+    tile (plus margin of one radius) are binned, and only bins with centers
+    inside tile are kept - so each hexagon belongs to exactly one tile & has
+    complete count (hexagons with centers out of world, at its edges, belong
+    to no tile). Bins centers are returned in tile pixels.
+
+    Radius (in tile pixels), order() & engine() are taken from specified
+    hexbin (extent() & clip() are not used). Tiles are kept in LRU cache of
+    `cache_tiles` tiles, so panning bins only newly exposed tiles.
+
+    Points are indexed by rows of `index_zoom` level (sorted by row, then by
+    u), so tile lookup is O(rows of tile * log(points) + points of tile
+    rows strip) - at zooms deeper than `index_zoom` strip is taller than
+    tile.
+
+    @code{.cpp}
+    d3_hexbin::HexbinTiles<decltype(hexbin)> tiles(hexbin.radius(16));
+    tiles.assign(lons.data(), lats.data(), lons.size());
+    const auto bins = tiles.tile(z, x, y); // std::shared_ptr<const std::vector<HexbinCount<double>>>
+    @endcode
+ */
+template <typename HexbinT>
+class HexbinTiles
+{
+public:
+
+    using hexbin_t = HexbinT;
+    using number_t = typename HexbinT::bin_t::number_t;
+    using count_t  = HexbinCount<number_t>;
+    using bins_t   = std::shared_ptr<const std::vector<count_t>>;
+
+    /// Zoom level of points index rows
+    static const unsigned index_zoom = 18;
+
+    /// Deepest zoom level of tile() (tile key packs x & y in 29 bits)
+    static const unsigned max_zoom = 29;
+
+private:
+    HexbinT     _hexbin;
+    std::size_t _tile_size;
+    std::size_t _capacity;
+
+    // Points in normalized Web Mercator coordinates ([0, 1] x [0, 1]),
+    // sorted by index row, then by u (for tile lookup)
+    std::vector<std::uint32_t> _rows;
+    std::vector<number_t>      _us;
+    std::vector<number_t>      _vs;
+
+    // scratch columns of tile points (in pixels)
+    std::vector<number_t> _xs;
+    std::vector<number_t> _ys;
+
+    // LRU cache: most recently used tiles go first
+    using _entry_t = std::pair<std::uint64_t, bins_t>;
+    std::list<_entry_t>                                                  _lru;
+    std::unordered_map<std::uint64_t, typename std::list<_entry_t>::iterator> _index;
+    std::size_t _hits   = 0;
+    std::size_t _misses = 0;
+
+    static std::uint32_t _row(number_t v) {
+        const number_t rows = static_cast<number_t>(std::uint32_t(1) << index_zoom);
+        return static_cast<std::uint32_t>( std::max(number_t(0), std::min(rows - 1, std::floor(v * rows))) );
+    }
+
+    // z: 5 bits, x & y: 29 bits
+    static std::uint64_t _key(unsigned z, std::uint32_t x, std::uint32_t y) {
+        return (static_cast<std::uint64_t>(z) << 58) | (static_cast<std::uint64_t>(x) << 29) | y;
+    }
+
+    static number_t _u(number_t lon) {
+        return (lon + 180) / 360;
+    }
+
+    static number_t _v(number_t lat) {
+        const number_t max_lat = 85.0511287798066; // atan(sinh(pi))
+        lat = std::max(-max_lat, std::min(max_lat, lat)) * static_cast<number_t>(M_PI) / 180;
+        return (1 - std::log(std::tan(lat) + 1 / std::cos(lat)) / static_cast<number_t>(M_PI)) / 2;
+    }
+
+    std::vector<count_t> _bin(unsigned z, std::uint32_t x, std::uint32_t y)
+    {
+        const number_t world = static_cast<number_t>(_tile_size) * std::ldexp(number_t(1), static_cast<int>(z));
+        const number_t x0 = static_cast<number_t>(x) * _tile_size, x1 = x0 + _tile_size;
+        const number_t y0 = static_cast<number_t>(y) * _tile_size, y1 = y0 + _tile_size;
+        const number_t margin = _hexbin.radius();
+
+        // points of tile (with margin): u ranges of index rows, covering tile
+        const number_t u0 = (x0 - margin) / world, u1 = (x1 + margin) / world;
+        const std::uint32_t last_row = _row((y1 + margin) / world);
+
+        _xs.clear();
+        _ys.clear();
+        auto row = std::lower_bound(_rows.begin(), _rows.end(), _row((y0 - margin) / world));
+        while (row != _rows.end() && *row <= last_row) {
+            const auto row_end = std::upper_bound(row, _rows.end(), *row);
+            const std::size_t begin = row - _rows.begin(), end = row_end - _rows.begin();
+
+            const auto first = std::lower_bound(_us.begin() + begin, _us.begin() + end, u0);
+            const auto last  = std::upper_bound(first,               _us.begin() + end, u1);
+            for (std::size_t i = first - _us.begin(); i < static_cast<std::size_t>(last - _us.begin()); ++i) {
+                const number_t py = _vs[i] * world;
+                if (py < y0 - margin || py > y1 + margin) continue;
+                _xs.push_back(_us[i] * world);
+                _ys.push_back(py);
+            }
+            row = row_end;
+        }
+
+        const std::vector<count_t> bins = _hexbin.counts(_xs.data(), _ys.data(), _xs.size());
+
+        std::vector<count_t> tile;
+        for (const count_t& bin : bins) {
+            if (bin.x >= x0 && bin.x < x1 && bin.y >= y0 && bin.y < y1)
+                tile.push_back({bin.x - x0, bin.y - y0, bin.count});
+        }
+        return tile;
+    }
+
+public:
+
+    explicit HexbinTiles(const HexbinT& hexbin, std::size_t tile_size = 256, std::size_t cache_tiles = 256)
+        : _hexbin(hexbin)
+        , _tile_size(tile_size)
+        , _capacity(cache_tiles > 0 ? cache_tiles : 1)
+    {
+        _hexbin.clip(false);
+    }
+
+    const HexbinT& hexbin() const {
+        return _hexbin;
+    }
+
+    std::size_t tile_size() const {
+        return _tile_size;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Sets points (longitudes & latitudes in degrees, latitudes are clamped
+        to Web Mercator limits, NaN points are skipped). Clears cache.
+     */
+    template <typename ColumnT>
+    void assign(const ColumnT* lons, const ColumnT* lats, std::size_t n)
+    {
+        struct Point {
+            std::uint32_t row;
+            number_t      u, v;
+
+            bool operator < (const Point& other) const {
+                return (row != other.row) ? (row < other.row) : (u < other.u);
+            }
+        };
+
+        std::vector<Point> points;
+        points.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const number_t lon = static_cast<number_t>(lons[i]), lat = static_cast<number_t>(lats[i]);
+            if (std::isnan(lon) || std::isnan(lat)) continue;
+            const number_t v = _v(lat);
+            points.push_back({_row(v), _u(lon), v});
+        }
+        std::sort(points.begin(), points.end());
+
+        _rows.resize(points.size());
+        _us.resize(points.size());
+        _vs.resize(points.size());
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            _rows[i] = points[i].row;
+            _us[i]   = points[i].u;
+            _vs[i]   = points[i].v;
+        }
+        clear();
+    }
+
+    /**
+        Returns bins of tile z/x/y (centers in tile pixels) - from cache, if
+        tile was binned recently. Tile out of world (z > max_zoom, x or y
+        not less than 2^z) has no bins (and is not cached).
+     */
+    bins_t tile(unsigned z, std::uint32_t x, std::uint32_t y)
+    {
+        if (z > max_zoom || x >> z != 0 || y >> z != 0)
+            return std::make_shared<const std::vector<count_t>>();
+
+        const std::uint64_t key = _key(z, x, y);
+        const auto found = _index.find(key);
+        if (found != _index.end()) {
+            ++_hits;
+            _lru.splice(_lru.begin(), _lru, found->second);
+            return found->second->second;
+        }
+
+        ++_misses;
+        const bins_t bins = std::make_shared<const std::vector<count_t>>( _bin(z, x, y) );
+        _lru.emplace_front(key, bins);
+        _index[key] = _lru.begin();
+        if (_lru.size() > _capacity) {
+            _index.erase(_lru.back().first);
+            _lru.pop_back();
+        }
+        return bins;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /// Returns cached tiles count
+    std::size_t size() const {
+        return _lru.size();
+    }
+
+    std::size_t hits() const {
+        return _hits;
+    }
+
+    std::size_t misses() const {
+        return _misses;
+    }
+
+    /// Clears cache (not points)
+    void clear()
+    {
+        _lru.clear();
+        _index.clear();
+    }
+};
+
+template <typename HexbinT>
+inline HexbinTiles<HexbinT> tiles(const HexbinT& hexbin, std::size_t tile_size = 256, std::size_t cache_tiles = 256) {
+    return HexbinTiles<HexbinT>(hexbin, tile_size, cache_tiles);
+}
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__TILES_HPP
@@ -0,0 +1,281 @@
+#ifndef D3__HEXBIN__WINDOW_HPP
+#define D3__HEXBIN__WINDOW_HPP
+
+#include "hexbin.hpp"
+
+namespace d3_hexbin {
+
+/**
+    Non-standart: rolling window binning. Points are added into the current
+    time slice, window keeps last `slices` slices in ring buffer - all slices
+    share radius, extent, accessors, clip() & order() of specified hexbin
+    (copied on construction).
+
+    advance() starts new slice, expiring the oldest one (when ring is full)
+    in O(bins of expired slice), instead of removing its points one by one.
+    Counts of the window (sum of live slices) are updated on the fly.
+
+    NOTICE: view is re-arranged lazily, on next counts() / snapshot(), in
+    O(live bins) - if bins were dropped by expiry (for any order), and after
+    every expiry of non-empty slice with `first_seen` order (bins are ordered
+    by their first live point, so they are re-ranked, walking bins of live
+    slices). So polling counts() after every advance() costs O(live bins)
+    per tick, not O(bins of expired slice).
+
+    @code{.cpp}
+    d3_hexbin::HexbinWindow<decltype(hexbin)> window(hexbin, 60); // 60 slices
+    window.add(point);       // into current slice
+    window.advance();        // every second: drop slice, older than 60 seconds
+    const auto& counts = window.counts();   // same as hexbin.counts(live points)
+    const auto  bins   = window.snapshot(); // same as hexbin(live points)
+    @endcode
+ */
+template <typename HexbinT>
+class HexbinWindow
+{
+public:
+
+    using hexbin_t = HexbinT;
+    using datum_t  = typename HexbinT::datum_t;
+    using bin_t    = typename HexbinT::bin_t;
+    using number_t = typename bin_t::number_t;
+    using count_t  = HexbinCount<number_t>;
+
+private:
+    struct _Slice
+    {
+        detail::CellTable                  table;
+        std::vector<std::vector<datum_t>>  bins;  // slot -> points, in order of adding
+        std::vector<std::uint64_t>         cells; // slot -> cell
+
+        void clear() {
+            table.clear();
+            bins.clear();
+            cells.clear();
+        }
+    };
+
+    HexbinT _hexbin;
+
+    std::vector<_Slice> _slices; // ring buffer
+    std::size_t         _head = 0; // current slice
+    std::size_t         _live = 1; // live slices count
+
+    // window view: sum of live slices
+    detail::CellTable          _table;
+    std::vector<count_t>       _counts;
+    std::vector<std::uint64_t> _cells;    // view slot -> cell
+    bool                       _arranged = true;
+    std::size_t                _dropped = 0; // zero-count bins, not removed from `_counts` yet
+
+    void _arrange() {
+        if (_arranged && _dropped == 0) return;
+
+        std::vector<std::size_t> order;
+        if (!_arranged) {
+            order = (_hexbin._order == HexbinOrder::first_seen) ? _first_seen_order()
+                                                                : _hexbin._ordering(_cells);
+        } else {
+            order.resize(_cells.size());
+            for (std::size_t k = 0; k < order.size(); ++k) order[k] = k;
+        }
+        if (_dropped != 0) {
+            order.erase(std::remove_if(order.begin(), order.end(), [this](std::size_t k) {
+                return _counts[k].count == 0;
+            }), order.end());
+        }
+
+        detail::permute(_counts, order);
+        detail::permute(_cells, order);
+        _arranged = true;
+        _dropped  = 0;
+
+        _table.clear();
+        for (std::size_t k = 0; k < _cells.size(); ++k)
+            _table.insert(_cells[k], static_cast<std::uint32_t>(k));
+    }
+
+    // View slots in order of first live point (from the oldest live slice)
+    std::vector<std::size_t> _first_seen_order() const {
+        std::vector<std::size_t> order;
+        order.reserve(_cells.size());
+        std::vector<bool> ranked(_cells.size(), false);
+        for (std::size_t s = 0; s < _live; ++s) {
+            const _Slice& slice = _slices[(_head + _slices.size() - _live + 1 + s) % _slices.size()];
+            for (const std::uint64_t cell : slice.cells) {
+                const std::uint32_t slot = _table.find(cell);
+                if (ranked[slot]) continue;
+                ranked[slot] = true;
+                order.push_back(slot);
+            }
+        }
+        return order;
+    }
+
+    // Subtracts slice from view & clears it
+    void _expire(_Slice& slice) {
+        if (_hexbin._order == HexbinOrder::first_seen && !slice.cells.empty())
+            _arranged = false; // first points of surviving bins may be in other order
+        for (std::size_t k = 0; k < slice.cells.size(); ++k) {
+            const std::uint32_t slot = _table.find(slice.cells[k]);
+            count_t& bin = _counts[slot];
+            bin.count -= slice.bins[k].size();
+            if (bin.count == 0) { // bin stays in `_counts` until next arrangement
+                _table.erase(slice.cells[k]);
+                ++_dropped;
+            }
+        }
+        slice.clear();
+    }
+
+public:
+
+    explicit HexbinWindow(const HexbinT& hexbin = HexbinT(), std::size_t slices = 1)
+        : _hexbin(hexbin)
+        , _slices(slices > 0 ? slices : 1)
+    {}
+
+    const HexbinT& hexbin() const {
+        return _hexbin;
+    }
+
+    /// Returns ring buffer capacity (max live slices count)
+    std::size_t slices() const {
+        return _slices.size();
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Adds point into the current slice. Returns false, if point is skipped
+        (NaN coordinate or out of extent, if clip() is set).
+     */
+    bool add(const datum_t& point)
+    {
+        int pi, pj;
+        if (!_hexbin._cell(point, pi, pj)) return false;
+
+        const std::uint64_t cell = detail::pack_cell(pi, pj);
+
+        _Slice& slice = _slices[_head];
+        const auto in_slice = slice.table.insert(cell, static_cast<std::uint32_t>(slice.bins.size()));
+        if (in_slice.second) {
+            slice.bins.emplace_back(1, point);
+            slice.cells.push_back(cell);
+        } else {
+            slice.bins[in_slice.first].push_back(point);
+        }
+
+        const auto in_view = _table.insert(cell, static_cast<std::uint32_t>(_counts.size()));
+        if (in_view.second) {
+            _counts.push_back({_hexbin._center_x(pi, pj), _hexbin._center_y(pj), 1});
+            _cells.push_back(cell);
+            _arranged = _arranged && (_hexbin._order == HexbinOrder::first_seen);
+        } else {
+            ++_counts[in_view.first].count;
+        }
+        return true;
+    }
+
+    template <typename Iterator>
+    void add(Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+            add(*first);
+    }
+
+    void add(const std::vector<datum_t>& points)
+    {
+        add(points.begin(), points.end());
+    }
+
+    /**
+        Starts new (empty) slice. If all slices are live, the oldest one is
+        expired - in O(bins of that slice).
+     */
+    void advance()
+    {
+        _head = (_head + 1) % _slices.size();
+        if (_live == _slices.size()) {
+            _expire(_slices[_head]);
+        } else {
+            ++_live;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    /**
+        Returns counts of live points - the same as Hexbin::counts() of all
+        live points. Returned reference is valid until next modification.
+     */
+    const std::vector<count_t>& counts()
+    {
+        _arrange();
+        return _counts;
+    }
+
+    /**
+        Returns bins of live points - the same as Hexbin::operator() of all
+        live points (points of each bin are ordered from the oldest slice to
+        the current one). Built on every call, in O(live points).
+     */
+    std::vector<bin_t> snapshot()
+    {
+        _arrange();
+
+        std::vector<bin_t> bins;
+        bins.reserve(_counts.size());
+        for (std::size_t k = 0; k < _counts.size(); ++k) {
+            bool opened = false;
+            for (std::size_t s = 0; s < _live; ++s) {
+                const _Slice& slice = _slices[(_head + _slices.size() - _live + 1 + s) % _slices.size()];
+                const std::uint32_t slot = slice.table.find(_cells[k]);
+                if (slot == detail::no_slot) continue;
+
+                const std::vector<datum_t>& points = slice.bins[slot];
+                if (!opened) {
+                    bins.emplace_back(points.front());
+                    _hexbin._place(bins.back(), detail::cell_i(_cells[k]), detail::cell_j(_cells[k]));
+                    bins.back().reserve(_counts[k].count);
+                    bins.back().insert(bins.back().end(), points.begin() + 1, points.end());
+                    opened = true;
+                } else {
+                    bins.back().insert(bins.back().end(), points.begin(), points.end());
+                }
+            }
+        }
+        return bins;
+    }
+
+    /// Returns bins count of live points
+    std::size_t size() const {
+        return _counts.size() - _dropped;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear()
+    {
+        for (_Slice& slice : _slices) slice.clear();
+        _head = 0;
+        _live = 1;
+
+        _table.clear();
+        _counts.clear();
+        _cells.clear();
+        _arranged = true;
+        _dropped  = 0;
+    }
+};
+
+template <typename HexbinT>
+inline HexbinWindow<HexbinT> window(const HexbinT& hexbin, std::size_t slices) {
+    return HexbinWindow<HexbinT>(hexbin, slices);
+}
+
+} // namespace d3_hexbin
+
+#endif // D3__HEXBIN__WINDOW_HPP
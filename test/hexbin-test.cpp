@@ -4,6 +4,83 @@
 #include "./pathEqual.hpp"
 
 #include "d3_hexbin/hexbin.hpp"
+#include "d3_hexbin/accumulator.hpp"
+#include "d3_hexbin/window.hpp"
+#include "d3_hexbin/partial.hpp"
+#if defined(__unix__) || defined(__APPLE__) // same check, as in mapped.hpp
+#include "d3_hexbin/mapped.hpp"
+#define HEXBIN_TEST_MAPPED
+#endif
+#include "d3_hexbin/csv.hpp"
+#include "d3_hexbin/tiles.hpp"
+#include "d3_hexbin/cache.hpp"
+
+#include <map>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Global heap allocations counter (enabled by `count_allocations`). All
+// replaceable forms are replaced, so every allocation & deallocation goes
+// through malloc() & free() (no new / delete mismatch under sanitizers).
+#if defined(__GNUC__)
+#define HEXBIN_TEST_NOINLINE __attribute__((noinline)) // no false -Wmismatched-new-delete
+#else
+#define HEXBIN_TEST_NOINLINE
+#endif
+
+static bool        count_allocations = false;
+static std::size_t allocations_count = 0;
+
+static void* counted_malloc(std::size_t size) noexcept {
+    if (count_allocations) ++allocations_count;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = counted_malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = counted_malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+HEXBIN_TEST_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+HEXBIN_TEST_NOINLINE void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    ::operator delete[](p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, std::size_t) noexcept {
+    ::operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    ::operator delete[](p);
+}
+#endif
 
 using point_t  = std::array<double, 2>;
 using extent_t = std::array<point_t, 2>;
@@ -56,6 +133,55 @@ std::vector<PointXY<number_t>> xy(const std::vector<d3_hexbin::HexbinBin<T, numb
     return result;
 }
 
+// Original std::map<std::string, ...> based binning, used as reference
+template <typename number_t>
+std::vector<d3_hexbin::HexbinBin<std::array<number_t, 2>, number_t>> legacyBins(const std::vector<std::array<number_t, 2>>& points, number_t radius) {
+    using bin_t = d3_hexbin::HexbinBin<std::array<number_t, 2>, number_t>;
+
+    const number_t dx = radius * 2 * std::sin(d3_hexbin::detail::thirdPi), dy = radius * 1.5;
+    std::map<std::string, bin_t> binsById;
+    for(const auto& point : points) {
+        number_t px = point[0], py = point[1];
+        if (std::isnan(px) || std::isnan(py)) continue;
+
+        int pj = std::round(py = py / dy);
+        int pi = std::round(px = (px / dx - (pj & 1) / 2.0) +0.00001);
+        const number_t py1 = py - pj;
+        if (std::abs(py1) * 3 > 1) {
+            const number_t
+                    px1 = px - pi,
+                    pi2 = pi + (px < pi ? -1 : 1) / 2,
+                    pj2 = pj + (py < pj ? -1 : 1),
+                    px2 = px - pi2,
+                    py2 = py - pj2;
+            if (px1 * px1 + py1 * py1 > px2 * px2 + py2 * py2) { pi = pi2 + (pj & 1 ? 1 : -1) / 2; pj = pj2; }
+        }
+
+        const std::string id = std::to_string(pi) + "-" + std::to_string(pj);
+        const auto bin_it = binsById.find(id);
+        if (bin_it != binsById.end()) {
+            bin_it->second.push_back(point);
+        } else {
+            bin_t bin(point);
+            bin.x = (pi + (pj & 1) / 2.0) * dx;
+            bin.y = pj * dy;
+            binsById.insert({id, bin});
+        }
+    }
+
+    std::vector<bin_t> bins;
+    for(const auto& kv : binsById) bins.push_back(kv.second);
+    return bins;
+}
+
+inline data_t randomPoints(std::size_t count, double lo, double hi, unsigned seed = 42) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(lo, hi);
+    data_t points(count);
+    for(auto& p : points) p = {dist(gen), dist(gen)};
+    return points;
+}
+
 // =============================================================================
 
 TEST_CASE("d3.hexbin() has the expected defaults") {
@@ -113,6 +239,30 @@ TEST_CASE("hexbin(points) observes the current x- and y-accessors") {
     });
 }
 
+TEST_CASE("hexbin(x, y) uses the specified accessor policies") {
+    const auto x = [](const PointXY<double>& d) { return d.x; };
+    const auto y = [](const PointXY<double>& d) { return d.y; };
+    auto b = d3_hexbin::hexbin<PointXY<double>, double, point_t>(x, y);
+    REQUIRE( b.x()({3, 4}) == 3 );
+    REQUIRE( b.y()({3, 4}) == 4 );
+
+    const std::vector<PointXY<double>> points = {
+        {/*x:*/ 0, /*y:*/ 0}, {/*x:*/ 0, /*y:*/ 1}, {/*x:*/ 0, /*y:*/ 2},
+        {/*x:*/ 1, /*y:*/ 0}, {/*x:*/ 1, /*y:*/ 1}, {/*x:*/ 1, /*y:*/ 2},
+        {/*x:*/ 2, /*y:*/ 0}, {/*x:*/ 2, /*y:*/ 1}, {/*x:*/ 2, /*y:*/ 2}
+    };
+    const auto expected = d3_hexbin::hexbin<PointXY<double>, double, point_t>().x(x).y(y)(points);
+    const auto bins = b(points);
+    REQUIRE( noxy(bins) == noxy(expected) );
+    REQUIRE( xy(bins) == xy(expected) );
+
+    // type-erased accessor overrides policy
+    const auto swapped = b.x(y)(points);
+    REQUIRE( b.x()({3, 4}) == 4 );
+    REQUIRE( noxy(swapped) == noxy(d3_hexbin::hexbin<PointXY<double>, double, point_t>().x(y).y(y)(points)) );
+    REQUIRE( noxy(swapped) != noxy(bins) );
+}
+
 TEST_CASE("hexbin(points) observes the current radius") {
     const auto bins = d3_hexbin::hexbin<datum_t, double, point_t>().radius(2)({
         {0, 0}, {0, 1}, {0, 2},
@@ -133,6 +283,1117 @@ TEST_CASE("hexbin(points) observes the current radius") {
     });
 }
 
+TEST_CASE("hexbin(points) returns bins in the same order as std::map based implementation") {
+    const auto points = randomPoints(5000, -50, 50);
+    const auto bins = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.5)(points);
+    const auto expected = legacyBins(points, 1.5);
+
+    REQUIRE( noxy(bins) == noxy(expected) );
+    REQUIRE( xy(bins) == xy(expected) );
+}
+
+TEST_CASE("hexbin.order() gets or sets the bins order") {
+    auto b = d3_hexbin::hexbin<datum_t, double, point_t>();
+    REQUIRE( b.order() == d3_hexbin::HexbinOrder::by_id );
+
+    const data_t points = {{20, 0}, {0, 0}, {20, 0}, {-20, 0}};
+    REQUIRE( noxy(b(points)) == std::vector<data_t>{
+        {{-20, 0}},
+        {{0, 0}},
+        {{20, 0}, {20, 0}}
+    });
+
+    b.order(d3_hexbin::HexbinOrder::first_seen);
+    REQUIRE( b.order() == d3_hexbin::HexbinOrder::first_seen );
+    REQUIRE( noxy(b(points)) == std::vector<data_t>{
+        {{20, 0}, {20, 0}},
+        {{0, 0}},
+        {{-20, 0}}
+    });
+}
+
+TEST_CASE("hexbin.engine(dense) returns the same bins as hash engine") {
+    const auto points = randomPoints(5000, -20, 120);
+    auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(2).extent({{ {0, 0}, {100, 100} }});
+    REQUIRE( b.engine() == d3_hexbin::HexbinEngine::hash );
+
+    const auto expected = b(points);
+    const auto bins = b.engine(d3_hexbin::HexbinEngine::dense)(points);
+    REQUIRE( b.engine() == d3_hexbin::HexbinEngine::dense );
+    REQUIRE( noxy(bins) == noxy(expected) );
+    REQUIRE( xy(bins) == xy(expected) );
+
+    // extent out of grid range falls back to hash engine
+    for(const double bound : {1e300, double(INFINITY)}) {
+        b.extent({{ {-bound, -bound}, {bound, bound} }});
+        REQUIRE( noxy(b(points)) == noxy(b.engine(d3_hexbin::HexbinEngine::hash)(points)) );
+        b.engine(d3_hexbin::HexbinEngine::dense);
+    }
+}
+
+TEST_CASE("hexbin.engine(sort) returns the same bins as hash engine") {
+    auto points = randomPoints(5000, -60, 60);
+    points[7] = {NAN, NAN};
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(2).order(order);
+        const auto expected = b(points);
+        const auto bins = b.engine(d3_hexbin::HexbinEngine::sort)(points);
+        REQUIRE( noxy(bins) == noxy(expected) );
+        REQUIRE( xy(bins) == xy(expected) );
+        REQUIRE( noxy(b.indices(points)) == noxy(b.engine(d3_hexbin::HexbinEngine::hash).indices(points)) );
+    }
+}
+
+TEST_CASE("hexbin.order(by_cell) sorts bins by rows, then columns") {
+    const data_t points = {{20, 0}, {0, 20}, {-20, 0}, {0, -20}, {0, 0}};
+    const auto bins = d3_hexbin::hexbin<datum_t, double, point_t>().order(d3_hexbin::HexbinOrder::by_cell)(points);
+    REQUIRE( noxy(bins) == std::vector<data_t>{
+        {{0, -20}},
+        {{-20, 0}},
+        {{0, 0}},
+        {{20, 0}},
+        {{0, 20}}
+    });
+}
+
+TEST_CASE("hexbin.clip() skips points out of extent") {
+    const data_t points = {{0, 0}, {-5, 5}, {5, 5}, {5, 12}, {10, 10}};
+    for(const auto engine : {d3_hexbin::HexbinEngine::hash, d3_hexbin::HexbinEngine::dense, d3_hexbin::HexbinEngine::sort}) {
+        auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(2).size({10, 10}).engine(engine);
+        REQUIRE( b.clip() == false );
+        REQUIRE( b(points).size() == 5 );
+        REQUIRE( noxy(b.clip(true)(points)) == std::vector<data_t>{
+            {{0, 0}},
+            {{5, 5}},
+            {{10, 10}}
+        });
+    }
+}
+
+TEST_CASE("hexbin.indices(points) bins the indices of specified points") {
+    const data_t points = {
+        {0, 0}, {0, 1}, {0, 2},
+        {1, 0}, {1, 1}, {1, 2},
+        {2, 0}, {2, 1}, {2, 2}
+    };
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>();
+    const auto bins = b.indices(points);
+
+    REQUIRE( noxy(bins) == std::vector<std::vector<std::size_t>>{
+        {0},
+        {1, 2, 4, 5},
+        {3, 6},
+        {7, 8}
+    });
+    REQUIRE( xy(bins) == xy(b(points)) );
+
+    const auto bins32 = b.indices<std::uint32_t>(points);
+    REQUIRE( bins32.size() == 4 );
+    REQUIRE( bins32[1] == std::vector<std::uint32_t>{1, 2, 4, 5} );
+}
+
+TEST_CASE("hexbin.counts(points) returns the number of points per bin") {
+    const auto points = randomPoints(2000, -10, 10);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.7);
+    const auto bins = b(points);
+    const auto counts = b.counts(points);
+
+    REQUIRE( counts.size() == bins.size() );
+    for(std::size_t i = 0; i < bins.size(); ++i) {
+        REQUIRE( counts[i].x == bins[i].x );
+        REQUIRE( counts[i].y == bins[i].y );
+        REQUIRE( counts[i].count == bins[i].size() );
+    }
+}
+
+TEST_CASE("hexbin.aggregate(points, aggregator) computes per-bin statistics") {
+    const auto points = randomPoints(3000, -10, 10);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.5);
+    const auto value = [](const datum_t& d) { return d[0] * d[1]; };
+
+    const auto bins  = b(points);
+    const auto stats = b.aggregate(points, d3_hexbin::aggregate::stats(value));
+    const auto sums  = b.aggregate(points, d3_hexbin::aggregate::sum(value));
+    const auto mins  = b.aggregate(points, d3_hexbin::aggregate::min(value));
+    const auto maxs  = b.aggregate(points, d3_hexbin::aggregate::max(value));
+    const auto means = b.aggregate(points, d3_hexbin::aggregate::mean(value));
+    const auto counts = b.aggregate<d3_hexbin::aggregate::Count>(points);
+
+    REQUIRE( stats.size() == bins.size() );
+    for(std::size_t i = 0; i < bins.size(); ++i) {
+        double sum = 0, min = INFINITY, max = -INFINITY;
+        for(const auto& d : bins[i]) { sum += value(d); min = std::min(min, value(d)); max = std::max(max, value(d)); }
+        const double mean = sum / bins[i].size();
+        double m2 = 0;
+        for(const auto& d : bins[i]) m2 += (value(d) - mean) * (value(d) - mean);
+
+        REQUIRE( stats[i].x == bins[i].x );
+        REQUIRE( stats[i].y == bins[i].y );
+        REQUIRE( stats[i].value.count == bins[i].size() );
+        REQUIRE( stats[i].value.sum  == Approx(sum) );
+        REQUIRE( stats[i].value.mean == Approx(mean) );
+        REQUIRE( stats[i].value.min  == min );
+        REQUIRE( stats[i].value.max  == max );
+        if (bins[i].size() > 1) REQUIRE( stats[i].value.variance == Approx(m2 / (bins[i].size() - 1)) );
+        else                    REQUIRE( std::isnan(stats[i].value.variance) );
+
+        REQUIRE( sums[i].value  == Approx(sum) );
+        REQUIRE( mins[i].value  == min );
+        REQUIRE( maxs[i].value  == max );
+        REQUIRE( means[i].value == Approx(mean) );
+        REQUIRE( counts[i].value == bins[i].size() );
+    }
+}
+
+TEST_CASE("aggregate::stats() merges partial states") {
+    const auto value = [](const datum_t& d) { return d[0]; };
+    const auto agg = d3_hexbin::aggregate::stats(value);
+    const data_t points = {{1, 0}, {2, 0}, {4, 0}, {8, 0}, {16, 0}};
+
+    auto all = agg.init(), left = agg.init(), right = agg.init();
+    for(std::size_t i = 0; i < points.size(); ++i) {
+        agg.accumulate(all, points[i]);
+        agg.accumulate(i < 2 ? left : right, points[i]);
+    }
+    agg.merge(left, right);
+
+    const auto expected = agg.finalize(all), merged = agg.finalize(left);
+    REQUIRE( merged.count == 5 );
+    REQUIRE( merged.sum == 31 );
+    REQUIRE( merged.min == 1 );
+    REQUIRE( merged.max == 16 );
+    REQUIRE( merged.mean == Approx(expected.mean) );
+    REQUIRE( merged.variance == Approx(expected.variance) );
+    REQUIRE( merged.variance == Approx(37.2) );
+}
+
+TEST_CASE("hexbin.indices(xs, ys, n) and hexbin.counts(xs, ys, n) bin columns of coordinates") {
+    auto points = randomPoints(3000, -30, 30);
+    points[10] = {NAN, 1};
+    points[20] = {1, NAN};
+
+    std::vector<float> xs, ys;
+    for(auto& p : points) {
+        p = {float(p[0]), float(p[1])};
+        xs.push_back(float(p[0]));
+        ys.push_back(float(p[1]));
+    }
+
+    for(const auto engine : {d3_hexbin::HexbinEngine::hash, d3_hexbin::HexbinEngine::dense}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.2).size({20, 20}).engine(engine);
+
+        const auto expected = b.indices(points);
+        const auto bins = b.indices(xs.data(), ys.data(), xs.size());
+        REQUIRE( noxy(bins) == noxy(expected) );
+        REQUIRE( xy(bins) == xy(expected) );
+
+        const auto counts = b.counts(xs.data(), ys.data(), xs.size());
+        REQUIRE( counts.size() == expected.size() );
+        for(std::size_t i = 0; i < counts.size(); ++i)
+            REQUIRE( counts[i].count == expected[i].size() );
+    }
+}
+
+TEST_CASE("SIMD quantize kernels produce the same cells as scalar code") {
+    using d3_hexbin::detail::QuantizeKernel;
+
+    const auto points = randomPoints(10001, -100, 100);
+    std::vector<double> xs, ys;
+    for(std::size_t i = 0; i < points.size(); ++i) {
+        // half-way values & NaNs
+        xs.push_back( (i % 7 == 0) ? std::round(points[i][0] * 4) / 4 : points[i][0] );
+        ys.push_back( (i % 11 == 0) ? std::round(points[i][1] * 2) * 0.75 : points[i][1] );
+        if (i % 101 == 0) xs.back() = NAN;
+        if (i % 103 == 0) ys.back() = NAN;
+    }
+
+    for(const double radius : {0.1, 0.5, 1.0, 2.3}) {
+        const double dx = radius * 2 * std::sin(d3_hexbin::detail::thirdPi), dy = radius * 1.5;
+        std::vector<int> si(xs.size()), sj(xs.size());
+        d3_hexbin::detail::quantize_scalar(xs.data(), ys.data(), xs.size(), dx, dy, si.data(), sj.data());
+
+        for(const auto kernel : {QuantizeKernel::sse41, QuantizeKernel::avx2, QuantizeKernel::avx512}) {
+            std::vector<int> vi(xs.size()), vj(xs.size());
+            if (!d3_hexbin::detail::quantize(kernel, xs.data(), ys.data(), xs.size(), dx, dy, vi.data(), vj.data()))
+                continue; // not supported
+            REQUIRE( vi == si );
+            REQUIRE( vj == sj );
+        }
+    }
+}
+
+TEST_CASE("hexbin.quantize(xs, ys, n, pi, pj) returns the cells of points") {
+    const auto points = randomPoints(1000, -10, 10);
+    std::vector<float> xs, ys;
+    for(const auto& p : points) { xs.push_back(float(p[0])); ys.push_back(float(p[1])); }
+
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.8).order(d3_hexbin::HexbinOrder::first_seen);
+    std::vector<int> pi(xs.size()), pj(xs.size());
+    b.quantize(xs.data(), ys.data(), xs.size(), pi.data(), pj.data());
+
+    std::vector<std::pair<int, int>> cells;
+    for(std::size_t i = 0; i < pi.size(); ++i)
+        if (std::find(cells.begin(), cells.end(), std::make_pair(pi[i], pj[i])) == cells.end())
+            cells.push_back({pi[i], pj[i]});
+
+    const auto bins = b.indices(xs.data(), ys.data(), xs.size());
+    REQUIRE( bins.size() == cells.size() );
+    for(std::size_t k = 0; k < bins.size(); ++k) {
+        for(const auto index : bins[k]) {
+            REQUIRE( pi[index] == cells[k].first );
+            REQUIRE( pj[index] == cells[k].second );
+        }
+        REQUIRE( bins[k].x == Approx((cells[k].first + (cells[k].second & 1) / 2.0) * 0.8 * std::sqrt(3.0)) );
+        REQUIRE( bins[k].y == Approx(cells[k].second * 0.8 * 1.5) );
+    }
+}
+
+TEST_CASE("hexbin(points, threads) returns the same bins for any threads count") {
+    auto points = randomPoints(20000, -40, 40);
+    points[123] = {NAN, 0};
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        for(const auto engine : {d3_hexbin::HexbinEngine::hash, d3_hexbin::HexbinEngine::dense}) {
+            const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.3).size({30, 30}).order(order).engine(engine);
+            const auto expected = b(points);
+            const auto expected_indices = b.indices(points);
+
+            for(const unsigned threads : {0u, 1u, 2u, 3u, 8u}) {
+                const auto bins = b(points, threads);
+                REQUIRE( noxy(bins) == noxy(expected) );
+                REQUIRE( xy(bins) == xy(expected) );
+                REQUIRE( noxy(b.indices(points, threads)) == noxy(expected_indices) );
+            }
+        }
+    }
+
+    REQUIRE( d3_hexbin::hexbin<datum_t, double, point_t>()(data_t{}, 4).empty() );
+}
+
+TEST_CASE("HexbinAccumulator.snapshot() returns the same bins as hexbin(points) of all added points") {
+    auto points = randomPoints(3000, -20, 20);
+    points[5] = {NAN, 1};
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.1).order(order);
+        auto acc = d3_hexbin::accumulator(b);
+        REQUIRE( acc.empty() );
+
+        data_t added;
+        for(std::size_t i = 0; i < points.size(); i += 500) {
+            const std::size_t end = std::min(points.size(), i + 500);
+            if (i == 0) {
+                for(std::size_t k = i; k < end; ++k) acc.add(points[k]);
+            } else {
+                acc.add(points.begin() + i, points.begin() + end);
+            }
+            added.insert(added.end(), points.begin() + i, points.begin() + end);
+
+            const auto& bins = acc.snapshot();
+            const auto expected = b(added);
+            REQUIRE( noxy(bins) == noxy(expected) );
+            REQUIRE( xy(bins) == xy(expected) );
+            REQUIRE( acc.size() == expected.size() );
+        }
+
+        REQUIRE( acc.add(datum_t{NAN, 0}) == false );
+        acc.clear();
+        REQUIRE( acc.snapshot().empty() );
+    }
+}
+
+TEST_CASE("HexbinAccumulator.remove() and decrement() take points out of bins") {
+    const auto points = randomPoints(4000, -15, 15);
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.9).order(order);
+        auto acc = d3_hexbin::accumulator(b);
+        acc.add(points);
+
+        // sliding window: remove oldest points
+        for(std::size_t i = 0; i < 2500; ++i) {
+            if (i % 2 == 0) {
+                REQUIRE( acc.remove(points[i]) );
+            } else {
+                int pi, pj;
+                b.quantize(&points[i][0], &points[i][1], 1, &pi, &pj);
+                REQUIRE( acc.decrement(d3_hexbin::detail::pack_cell(pi, pj)) );
+            }
+
+            if (i % 500 == 0) {
+                const auto expected = b(data_t(points.begin() + i + 1, points.end()));
+                const auto& bins = acc.snapshot();
+                REQUIRE( noxy(bins) == noxy(expected) );
+                REQUIRE( xy(bins) == xy(expected) );
+                REQUIRE( acc.ids().size() == bins.size() );
+            }
+        }
+
+        const auto expected = b(data_t(points.begin() + 2500, points.end()));
+        REQUIRE( acc.size() == expected.size() );
+        REQUIRE( noxy(acc.snapshot()) == noxy(expected) );
+
+        REQUIRE( acc.remove(points[0]) == false );
+        REQUIRE( acc.decrement(d3_hexbin::detail::pack_cell(100000, 100000)) == false );
+    }
+}
+
+TEST_CASE("HexbinAccumulator drops bins whose count reaches zero") {
+    auto acc = d3_hexbin::accumulator( d3_hexbin::hexbin<datum_t, double, point_t>().order(d3_hexbin::HexbinOrder::first_seen) );
+    acc.add(data_t{{0, 0}, {10, 0}, {0, 0}, {20, 0}});
+    REQUIRE( acc.size() == 3 );
+
+    const auto id = acc.ids()[1];
+    REQUIRE( acc.decrement(id) );
+    REQUIRE( acc.size() == 2 );
+    REQUIRE( acc.decrement(id) == false );
+    REQUIRE( noxy(acc.snapshot()) == std::vector<data_t>{
+        {{0, 0}, {0, 0}},
+        {{20, 0}}
+    });
+
+    acc.add(datum_t{10, 0});
+    REQUIRE( noxy(acc.snapshot()) == std::vector<data_t>{
+        {{0, 0}, {0, 0}},
+        {{20, 0}},
+        {{10, 0}}
+    });
+}
+
+TEST_CASE("HexbinWindow keeps bins of the last slices") {
+    const auto points = randomPoints(6000, -15, 15);
+    const std::size_t slice = 500;
+    const std::size_t slices = 4;
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.9).order(order);
+        auto window = d3_hexbin::window(b, slices);
+        REQUIRE( window.slices() == slices );
+
+        for(std::size_t i = 0; i < points.size(); i += slice) {
+            if (i != 0) window.advance();
+            window.add(points.begin() + i, points.begin() + i + slice);
+
+            const std::size_t first = (i + slice > slices * slice) ? (i + slice - slices * slice) : 0;
+            const data_t live(points.begin() + first, points.begin() + i + slice);
+
+            const auto expected = b(live);
+            const auto bins = window.snapshot();
+            REQUIRE( noxy(bins) == noxy(expected) );
+            REQUIRE( xy(bins) == xy(expected) );
+
+            const auto expected_counts = b.counts(live);
+            const auto& counts = window.counts();
+            REQUIRE( counts.size() == expected_counts.size() );
+            REQUIRE( window.size() == expected_counts.size() );
+            for(std::size_t k = 0; k < counts.size(); ++k) {
+                REQUIRE( counts[k].x == expected_counts[k].x );
+                REQUIRE( counts[k].y == expected_counts[k].y );
+                REQUIRE( counts[k].count == expected_counts[k].count );
+            }
+        }
+
+        for(std::size_t s = 0; s < slices; ++s) window.advance();
+        REQUIRE( window.empty() );
+        REQUIRE( window.snapshot().empty() );
+        REQUIRE( window.counts().empty() );
+    }
+}
+
+TEST_CASE("HexbinWindow re-ranks first_seen bins by their first live point") {
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1).order(d3_hexbin::HexbinOrder::first_seen);
+    auto window = d3_hexbin::window(b, 2);
+
+    const datum_t a = {0, 0}, c = {10, 10};
+    window.add(a);          // slice 0: A
+    window.advance();
+    window.add(c);          // slice 1: B, A
+    window.add(a);
+    REQUIRE( xy(window.snapshot()) == xy(b(data_t{a, c, a})) );
+
+    window.advance();       // slice 0 expires: live points are B, A
+    REQUIRE( xy(window.snapshot()) == xy(b(data_t{c, a})) );
+    REQUIRE( window.counts().front().x == b(data_t{c, a}).front().x );
+}
+
+TEST_CASE("merged partials of shards are the same as bins of concatenated shards") {
+    const auto points = randomPoints(3000, -15, 15);
+    const data_t shard_a(points.begin(), points.begin() + 1000);
+    const data_t shard_b(points.begin() + 1000, points.begin() + 1800);
+    const data_t shard_c(points.begin() + 1800, points.end());
+
+    const auto count = d3_hexbin::aggregate::count();
+    const auto stats = d3_hexbin::aggregate::stats([](const datum_t& d) { return d[0] * d[1]; });
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.8).order(order);
+
+        // counts, through binary encoding
+        auto counts = b.partial(shard_a, count);
+        for(const data_t* shard : {&shard_b, &shard_c}) {
+            d3_hexbin::HexbinPartial<std::size_t> decoded;
+            REQUIRE( d3_hexbin::decode(d3_hexbin::encode(b.partial(*shard, count)), decoded) );
+            counts = d3_hexbin::merge(counts, decoded, count);
+        }
+        const auto expected_counts = b.counts(points);
+        const auto actual_counts = b.counts(counts);
+        REQUIRE( actual_counts.size() == expected_counts.size() );
+        for(std::size_t k = 0; k < actual_counts.size(); ++k) {
+            REQUIRE( actual_counts[k].x == expected_counts[k].x );
+            REQUIRE( actual_counts[k].y == expected_counts[k].y );
+            REQUIRE( actual_counts[k].count == expected_counts[k].count );
+        }
+
+        // aggregator states
+        const auto merged = d3_hexbin::merge(d3_hexbin::merge(b.partial(shard_a, stats), b.partial(shard_b, stats), stats),
+                                             b.partial(shard_c, stats), stats);
+        const auto expected_stats = b.aggregate(points, stats);
+        const auto actual_stats = b.aggregate(merged, stats);
+        REQUIRE( actual_stats.size() == expected_stats.size() );
+        for(std::size_t k = 0; k < actual_stats.size(); ++k) {
+            REQUIRE( actual_stats[k].x == expected_stats[k].x );
+            REQUIRE( actual_stats[k].value.count == expected_stats[k].value.count );
+            REQUIRE( actual_stats[k].value.sum == Approx(expected_stats[k].value.sum) );
+        }
+
+        // indices lists, through binary encoding
+        auto indices = b.partial_indices<std::uint32_t>(shard_a);
+        for(const data_t* shard : {&shard_b, &shard_c}) {
+            d3_hexbin::HexbinPartial<std::vector<std::uint32_t>> decoded;
+            REQUIRE( d3_hexbin::decode(d3_hexbin::encode(b.partial_indices<std::uint32_t>(*shard)), decoded) );
+            indices = d3_hexbin::merge(indices, decoded);
+        }
+        REQUIRE( indices.points == points.size() );
+        const auto expected = b.indices<std::uint32_t>(points);
+        const auto actual = b.indices(indices);
+        REQUIRE( actual == expected );
+        REQUIRE( xy(actual) == xy(expected) );
+    }
+}
+
+TEST_CASE("decode() rejects malformed partials") {
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>();
+    const auto bytes = d3_hexbin::encode( b.partial(data_t{{0, 0}, {5, 5}, {0, 0}}, d3_hexbin::aggregate::count()) );
+
+    d3_hexbin::HexbinPartial<std::size_t> counts;
+    REQUIRE( d3_hexbin::decode(bytes, counts) );
+    REQUIRE( counts.points == 3 );
+    REQUIRE( counts.states == std::vector<std::size_t>{2, 1} );
+
+    REQUIRE_FALSE( d3_hexbin::decode(std::vector<std::uint8_t>(bytes.begin(), bytes.end() - 1), counts) );
+    REQUIRE_FALSE( d3_hexbin::decode(std::vector<std::uint8_t>(), counts) );
+
+    d3_hexbin::HexbinPartial<float> other;
+    REQUIRE_FALSE( d3_hexbin::decode(bytes, other) );
+    d3_hexbin::HexbinPartial<std::vector<std::size_t>> lists;
+    REQUIRE_FALSE( d3_hexbin::decode(bytes, lists) );
+
+    // Header of `bytes`, 2 points, bins with given key deltas
+    const auto forge = [&bytes](std::uint64_t delta0, std::uint64_t delta1) {
+        std::vector<std::uint8_t> forged(bytes.begin(), bytes.begin() + 9);
+        d3_hexbin::detail::put_varint(forged, 2);
+        d3_hexbin::detail::put_varint(forged, 2);
+        for (const std::uint64_t delta : {delta0, delta1}) {
+            d3_hexbin::detail::put_varint(forged, delta);
+            d3_hexbin::detail::put_varint(forged, 0);
+            d3_hexbin::detail::PartialCodec<std::size_t>::put(forged, 1);
+        }
+        return forged;
+    };
+    REQUIRE( d3_hexbin::decode(forge(5, 1), counts) );
+    REQUIRE_FALSE( d3_hexbin::decode(forge(5, 0), counts) );
+    REQUIRE_FALSE( d3_hexbin::decode(forge(~0ULL, 2), counts) );
+
+    auto swapped = bytes;
+    swapped[6] ^= 1;
+    REQUIRE_FALSE( d3_hexbin::decode(swapped, counts) );
+}
+
+#ifdef HEXBIN_TEST_MAPPED
+TEST_CASE("MappedPoints bins binary points file in place") {
+    const auto points = randomPoints(5000, -15, 15);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.7);
+    const char* path = "hexbin-test-points.bin";
+
+    // records: 8 bytes header, then (id: u32, x: f32, value: f32, y: f32)
+    data_t rounded;
+    {
+        std::FILE* file = std::fopen(path, "wb");
+        REQUIRE( file != nullptr );
+        std::fwrite("HEADER!!", 1, 8, file);
+        for(std::uint32_t i = 0; i < points.size(); ++i) {
+            const float record[4] = {0, static_cast<float>(points[i][0]), 1, static_cast<float>(points[i][1])};
+            std::fwrite(&i, sizeof(i), 1, file);
+            std::fwrite(&record[1], sizeof(float), 3, file);
+            rounded.push_back({record[1], record[3]});
+        }
+        std::fwrite("tail", 1, 4, file); // incomplete record
+        std::fclose(file);
+    }
+
+    {
+        const d3_hexbin::MappedPoints<float> file(path, {16, 4, 12, 8});
+        REQUIRE( file.is_open() );
+        REQUIRE( file.size() == points.size() );
+
+        const auto expected = b.indices(rounded);
+        const auto actual = b.indices(file.xs(), file.ys(), file.size());
+        REQUIRE( actual == expected );
+        REQUIRE( xy(actual) == xy(expected) );
+
+        const auto counts = b.counts(file.xs(), file.ys(), file.size());
+        REQUIRE( counts.size() == expected.size() );
+        for(std::size_t k = 0; k < counts.size(); ++k)
+            REQUIRE( counts[k].count == expected[k].size() );
+    }
+    std::remove(path);
+
+    REQUIRE_FALSE( d3_hexbin::MappedPoints<double>("no-such-file.bin").is_open() );
+}
+#endif // HEXBIN_TEST_MAPPED
+
+TEST_CASE("HexbinCsv bins CSV text streamed by chunks") {
+    const auto points = randomPoints(3000, -15, 15);
+
+    std::string text = "id;value;x;y\n";
+    for(std::size_t i = 0; i < points.size(); ++i) {
+        char row[128];
+        std::snprintf(row, sizeof(row), "%zu;%d; %.17g;%.17g\r\n", i, int(i % 7), points[i][0], points[i][1]);
+        text += row;
+        if (i % 1000 == 0) text += "bad;row;x;\n\n";
+    }
+    text += "bad;sign;+-5;1\nbad;sign;+ 5;1\n";
+    text += "plus;0;+0.5;+.5\n";
+    text += "last;0;1.5;2.5"; // no newline at end
+
+    data_t expected_points = points;
+    expected_points.push_back({0.5, 0.5});
+    expected_points.push_back({1.5, 2.5});
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.6).order(order);
+        const auto expected = b.counts(expected_points);
+
+        for(const std::size_t chunk : {std::size_t(7), std::size_t(4096)}) {
+            d3_hexbin::HexbinCsv<decltype(b)> csv(b, 2, 3, ';', true, chunk);
+            std::istringstream in(text);
+            REQUIRE( csv.read(in) );
+            REQUIRE( csv.rows() == expected_points.size() + 5 );
+            REQUIRE( csv.skipped() == 5 );
+
+            const auto& counts = csv.counts();
+            REQUIRE( counts.size() == expected.size() );
+            for(std::size_t k = 0; k < counts.size(); ++k) {
+                REQUIRE( counts[k].x == expected[k].x );
+                REQUIRE( counts[k].y == expected[k].y );
+                REQUIRE( counts[k].count == expected[k].count );
+            }
+        }
+    }
+}
+
+// Stateful allocator, which counts allocations
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    std::size_t* allocations;
+
+    explicit CountingAllocator(std::size_t* allocations_) : allocations(allocations_) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : allocations(other.allocations) {}
+
+    T* allocate(std::size_t n) {
+        ++*allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U> bool operator == (const CountingAllocator<U>& other) const { return allocations == other.allocations; }
+    template <typename U> bool operator != (const CountingAllocator<U>& other) const { return allocations != other.allocations; }
+};
+
+TEST_CASE("hexbin(points, alloc) allocates bins by specified allocator") {
+    const auto points = randomPoints(2000, -15, 15);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.9);
+    const auto expected = b(points);
+
+    std::size_t allocations = 0;
+    const auto bins = b(points, CountingAllocator<datum_t>(&allocations));
+    REQUIRE( allocations >= expected.size() + 1 );
+    REQUIRE( bins.get_allocator().allocations == &allocations );
+    REQUIRE( bins.size() == expected.size() );
+    for(std::size_t k = 0; k < bins.size(); ++k) {
+        REQUIRE( bins[k].get_allocator().allocations == &allocations );
+        REQUIRE( data_t(bins[k].begin(), bins[k].end()) == expected[k] );
+        REQUIRE( bins[k].x == expected[k].x );
+        REQUIRE( bins[k].y == expected[k].y );
+    }
+
+#ifdef D3_HEXBIN_HAS_PMR
+    // whole result in arena, which can't grow
+    std::vector<char> buffer(4 << 20);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    const auto pmr_bins = b(points, std::pmr::polymorphic_allocator<datum_t>(&arena));
+    REQUIRE( pmr_bins.size() == expected.size() );
+    for(std::size_t k = 0; k < pmr_bins.size(); ++k) {
+        REQUIRE( pmr_bins[k].get_allocator().resource() == &arena );
+        REQUIRE( data_t(pmr_bins[k].begin(), pmr_bins[k].end()) == expected[k] );
+    }
+#endif
+}
+
+TEST_CASE("hexbin.csr() returns the same bins in compressed-sparse-row form") {
+    const auto points = randomPoints(3000, -15, 15);
+
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.8).order(order);
+        const auto expected = b(points);
+        const auto expected_indices = b.indices<std::uint32_t>(points);
+
+        for(const unsigned threads : {1u, 4u}) {
+            const auto csr = b.csr(points, threads);
+            const auto csr_indices = b.csr_indices<std::uint32_t>(points, threads);
+            REQUIRE( csr.size() == expected.size() );
+            REQUIRE( csr_indices.size() == expected.size() );
+            REQUIRE( csr.items.size() == points.size() );
+            REQUIRE( csr.bins.back().offset == points.size() );
+
+            for(std::size_t k = 0; k < csr.size(); ++k) {
+                REQUIRE( csr.bins[k].x == expected[k].x );
+                REQUIRE( csr.bins[k].y == expected[k].y );
+                REQUIRE( csr.count(k) == expected[k].size() );
+                REQUIRE( data_t(csr.begin(k), csr.end(k)) == expected[k] );
+                REQUIRE( std::vector<std::uint32_t>(csr_indices.begin(k), csr_indices.end(k)) == expected_indices[k] );
+            }
+        }
+    }
+
+    REQUIRE( d3_hexbin::hexbin<datum_t, double, point_t>().csr(data_t{}).empty() );
+}
+
+TEST_CASE("hexbin(points, workspace) makes no allocations in steady state") {
+    for(const auto engine : {d3_hexbin::HexbinEngine::hash, d3_hexbin::HexbinEngine::dense})
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen, d3_hexbin::HexbinOrder::by_cell}) {
+        const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.9).extent({{{-15, -15}, {15, 15}}})
+                                                                     .engine(engine).order(order);
+        d3_hexbin::HexbinWorkspace<datum_t, double> workspace;
+
+        std::vector<data_t> frames;
+        for(unsigned seed = 0; seed < 4; ++seed)
+            frames.push_back( randomPoints(2000, -15, 15, seed) );
+
+        for(int pass = 0; pass < 3; ++pass) { // warm up
+            for(const data_t& frame : frames) {
+                const auto& bins = b(frame, workspace);
+                REQUIRE( bins == b(frame) );
+                REQUIRE( xy(bins) == xy(b(frame)) );
+            }
+        }
+
+        allocations_count = 0;
+        count_allocations = true;
+        for(const data_t& frame : frames)
+            b(frame, workspace);
+        count_allocations = false;
+
+        REQUIRE( allocations_count == 0 );
+        REQUIRE( workspace.bins() == b(frames.back()) );
+    }
+}
+
+TEST_CASE("hexbin.pyramid() derives coarser levels from the finest bins") {
+    const auto points = randomPoints(5000, -20, 20);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.5);
+
+    const auto pyramid = b.pyramid(points, 4);
+    REQUIRE( pyramid.size() == 4 );
+
+    const auto finest = b.counts(points);
+    REQUIRE( pyramid[0].size() == finest.size() );
+    for(std::size_t k = 0; k < finest.size(); ++k) {
+        REQUIRE( pyramid[0][k].x == finest[k].x );
+        REQUIRE( pyramid[0][k].count == finest[k].count );
+    }
+
+    for(std::size_t level = 1; level < pyramid.size(); ++level) {
+        REQUIRE( pyramid[level].size() < pyramid[level - 1].size() );
+        std::size_t total = 0;
+        for(const auto& bin : pyramid[level]) total += bin.count;
+        REQUIRE( total == points.size() );
+    }
+
+    // points at fine bins centers are binned exactly on every level
+    data_t centers;
+    for(const auto& bin : finest) centers.push_back({bin.x, bin.y});
+    const auto exact_pyramid = b.pyramid(centers, 4, 3.0);
+    for(std::size_t level = 0; level < exact_pyramid.size(); ++level) {
+        const auto exact = d3_hexbin::hexbin<datum_t, double, point_t>().radius(0.5 * std::pow(3.0, double(level))).counts(centers);
+        REQUIRE( exact_pyramid[level].size() == exact.size() );
+        for(std::size_t k = 0; k < exact.size(); ++k) {
+            REQUIRE( exact_pyramid[level][k].x == exact[k].x );
+            REQUIRE( exact_pyramid[level][k].y == exact[k].y );
+            REQUIRE( exact_pyramid[level][k].count == exact[k].count );
+        }
+    }
+
+    // aggregator states are merged
+    const auto sums = b.pyramid(points, 3, 2.0, d3_hexbin::aggregate::sum([](const datum_t& d) { return d[0]; }));
+    double expected_sum = 0;
+    for(const auto& p : points) expected_sum += p[0];
+    for(const auto& level : sums) {
+        double sum = 0;
+        for(const auto& bin : level) sum += bin.value;
+        REQUIRE( sum == Approx(expected_sum) );
+    }
+}
+
+TEST_CASE("HexbinTiles bins slippy-map tiles on globally aligned grid") {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> lon(-180, 180), lat(-80, 80);
+    std::vector<double> lons, lats;
+    for(int i = 0; i < 20000; ++i) {
+        lons.push_back(lon(generator));
+        lats.push_back(lat(generator));
+    }
+
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(10).order(d3_hexbin::HexbinOrder::by_cell);
+    auto tiles = d3_hexbin::tiles(b, 256, 8);
+    tiles.assign(lons.data(), lats.data(), lons.size());
+
+    // whole world at zoom 2, binned at once, bins are split by tiles of their centers
+    const unsigned z = 2;
+    const double world = 256 * 4;
+    data_t projected;
+    for(std::size_t i = 0; i < lons.size(); ++i) {
+        const double phi = lats[i] * M_PI / 180;
+        const double u = (lons[i] + 180) / 360;
+        const double v = (1 - std::log(std::tan(phi) + 1 / std::cos(phi)) / M_PI) / 2;
+        projected.push_back({u * world, v * world});
+    }
+    std::map<std::pair<int, int>, std::vector<d3_hexbin::HexbinCount<double>>> expected;
+    std::size_t expected_total = 0; // bins with centers out of world are not in any tile
+    for(const auto& bin : b.counts(projected)) {
+        const int tx = int(std::floor(bin.x / 256)), ty = int(std::floor(bin.y / 256));
+        expected[{tx, ty}].push_back({bin.x - tx * 256, bin.y - ty * 256, bin.count});
+        if (tx >= 0 && tx < 4 && ty >= 0 && ty < 4) expected_total += bin.count;
+    }
+
+    std::size_t total = 0;
+    for(std::uint32_t ty = 0; ty < 4; ++ty)
+    for(std::uint32_t tx = 0; tx < 4; ++tx) {
+        const auto bins = tiles.tile(z, tx, ty);
+        const auto& exp = expected[{int(tx), int(ty)}];
+        REQUIRE( bins->size() == exp.size() );
+        for(std::size_t k = 0; k < exp.size(); ++k) {
+            REQUIRE( (*bins)[k].x == Approx(exp[k].x) );
+            REQUIRE( (*bins)[k].y == Approx(exp[k].y) );
+            REQUIRE( (*bins)[k].count == exp[k].count );
+            total += exp[k].count;
+        }
+    }
+    REQUIRE( total == expected_total );
+    REQUIRE( total > lons.size() * 99 / 100 );
+
+    // cache
+    REQUIRE( tiles.misses() == 16 );
+    REQUIRE( tiles.size() == 8 );
+    const auto cached = tiles.tile(z, 3, 3);
+    REQUIRE( tiles.hits() == 1 );
+    REQUIRE( cached == tiles.tile(z, 3, 3) );
+    tiles.tile(z, 0, 0); // evicted
+    REQUIRE( tiles.misses() == 17 );
+
+    // zoom deeper than index rows: points at center of tile
+    const unsigned deep = 20;
+    const std::uint32_t tx = 600000, ty = 400000;
+    const double u = (tx + 0.5) / (1 << deep), v = (ty + 0.5) / (1 << deep);
+    std::vector<double> center_lons(50, u * 360 - 180), center_lats(50, std::atan(std::sinh(M_PI * (1 - 2 * v))) * 180 / M_PI);
+    center_lons.push_back(u * 360 - 180 + 1e-3); // out of tile
+    center_lats.push_back(center_lats.front());
+    tiles.assign(center_lons.data(), center_lats.data(), center_lons.size());
+    const auto deep_bins = tiles.tile(deep, tx, ty);
+    REQUIRE( deep_bins->size() == 1 );
+    REQUIRE( deep_bins->front().count == 50 );
+    REQUIRE( tiles.tile(deep, tx, ty + 1)->empty() );
+
+    // tiles out of world
+    const std::size_t misses = tiles.misses(), size = tiles.size();
+    REQUIRE( tiles.tile(2, 4, 0)->empty() );
+    REQUIRE( tiles.tile(2, 0, 4)->empty() );
+    REQUIRE( tiles.tile(30, 0, 0)->empty() );
+    REQUIRE( tiles.tile(deep + 32, tx, ty)->empty() ); // would alias deep/tx/ty key
+    REQUIRE( tiles.misses() == misses );
+    REQUIRE( tiles.size() == size );
+}
+
+TEST_CASE("hexbin.bin_ids() writes bin id of each point") {
+    std::mt19937 generator(13);
+    std::uniform_real_distribution<double> coord(-10, 110);
+    data_t points;
+    for(int i = 0; i < 3000; ++i) points.push_back({coord(generator), coord(generator)});
+    points.push_back({std::numeric_limits<double>::quiet_NaN(), 0}); // skipped
+
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(3).extent({{{0, 0}, {100, 100}}}).clip(true);
+
+    std::vector<std::uint64_t> ids;
+    b.bin_ids(points, ids);
+    REQUIRE( ids.size() == points.size() );
+
+    // each point gets id of its bin, skipped points - no_cell
+    std::vector<bool> binned(points.size(), false);
+    for(const auto& bin : b.indices(points)) {
+        const std::uint64_t id = ids[bin.front()];
+        const int pi = d3_hexbin::detail::cell_i(id), pj = d3_hexbin::detail::cell_j(id);
+        REQUIRE( bin.x == Approx((pi + (pj & 1) / 2.0) * 3 * std::sqrt(3.0)) );
+        REQUIRE( bin.y == Approx(pj * 4.5) );
+        for(const std::size_t i : bin) {
+            REQUIRE( ids[i] == id );
+            binned[i] = true;
+        }
+    }
+    std::size_t skipped = 0;
+    for(std::size_t i = 0; i < points.size(); ++i) {
+        if (binned[i]) continue;
+        REQUIRE( ids[i] == d3_hexbin::detail::no_cell );
+        ++skipped;
+    }
+    REQUIRE( skipped > 1 );
+
+    // structure-of-arrays input
+    std::vector<double> xs, ys;
+    for(const auto& p : points) {
+        xs.push_back(p[0]);
+        ys.push_back(p[1]);
+    }
+    std::vector<std::uint64_t> soa_ids(points.size());
+    b.bin_ids(xs.data(), ys.data(), xs.size(), soa_ids.data());
+    REQUIRE( soa_ids == ids );
+}
+
+TEST_CASE("bins carry offset coordinates, hexbin converts hexagon coordinates") {
+    const auto points = randomPoints(3000, -20, 20);
+    const auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(1.5);
+    using hexbin_t = std::remove_const<decltype(b)>::type;
+
+    const auto check = [&b](double x, double y, int i, int j) {
+        REQUIRE( b.cell_of(x, y) == (d3_hexbin::HexbinOffset{i, j}) );
+        REQUIRE( b.center_of(i, j)[0] == x );
+        REQUIRE( b.center_of(i, j)[1] == y );
+    };
+
+    const auto bins = b(points);
+    for(const auto& bin : bins) check(bin.x, bin.y, bin.i, bin.j);
+    for(const auto& bin : b.indices(points)) check(bin.x, bin.y, bin.i, bin.j);
+
+    d3_hexbin::HexbinWorkspace<datum_t, double> workspace;
+    for(const auto& bin : b(points, workspace)) check(bin.x, bin.y, bin.i, bin.j);
+
+    auto acc = d3_hexbin::accumulator(b);
+    acc.add(points.begin(), points.end());
+    for(const auto& bin : acc.snapshot()) check(bin.x, bin.y, bin.i, bin.j);
+
+    auto window = d3_hexbin::window(b, 2);
+    window.add(points.begin(), points.end());
+    for(const auto& bin : window.snapshot()) check(bin.x, bin.y, bin.i, bin.j);
+
+    // ids
+    std::vector<std::uint64_t> ids;
+    b.bin_ids(points, ids);
+    for(std::size_t k = 0; k < points.size(); ++k) {
+        const auto cell = b.cell_of(points[k][0], points[k][1]);
+        REQUIRE( hexbin_t::id_of(cell) == ids[k] );
+        REQUIRE( hexbin_t::cell_of(ids[k]) == cell );
+        REQUIRE( b.center_of(ids[k]) == b.center_of(cell) );
+    }
+    REQUIRE( b.cell_of(NAN, 0).i == d3_hexbin::detail::invalid_cell );
+
+    // conversions & neighbours
+    const d3_hexbin::HexbinCube directions[6] = {{1, -1, 0}, {1, 0, -1}, {0, 1, -1}, {-1, 1, 0}, {-1, 0, 1}, {0, -1, 1}};
+    for(int j = -5; j <= 5; ++j)
+    for(int i = -5; i <= 5; ++i) {
+        const d3_hexbin::HexbinOffset offset{i, j};
+        const auto axial = hexbin_t::offset_to_axial(offset);
+        const auto cube  = hexbin_t::offset_to_cube(offset);
+        REQUIRE( cube.x + cube.y + cube.z == 0 );
+        REQUIRE( hexbin_t::axial_to_offset(axial) == offset );
+        REQUIRE( hexbin_t::cube_to_offset(cube) == offset );
+        REQUIRE( hexbin_t::cube_to_axial(cube) == axial );
+        REQUIRE( hexbin_t::axial_to_cube(axial) == cube );
+
+        const auto center = b.center_of(offset);
+        for(const auto& d : directions) {
+            const auto neighbour = hexbin_t::cube_to_offset({cube.x + d.x, cube.y + d.y, cube.z + d.z});
+            const auto other = b.center_of(neighbour);
+            REQUIRE( std::hypot(other[0] - center[0], other[1] - center[1]) == Approx(1.5 * std::sqrt(3.0)) );
+        }
+    }
+}
+
+TEST_CASE("HexbinCache memoizes results by dataset version & configuration") {
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> coord(0, 100);
+    data_t points;
+    for(int i = 0; i < 2000; ++i) points.push_back({coord(generator), coord(generator)});
+
+    auto b = d3_hexbin::hexbin<datum_t, double, point_t>().radius(5);
+    d3_hexbin::HexbinCache<decltype(b)> cache(1 << 20);
+
+    const auto same_bins = [&b, &points](const std::vector<decltype(b)::bin_t>& bins) {
+        const auto expected = b(points);
+        REQUIRE( bins.size() == expected.size() );
+        for(std::size_t k = 0; k < bins.size(); ++k) {
+            REQUIRE( bins[k].x == expected[k].x );
+            REQUIRE( bins[k].y == expected[k].y );
+            REQUIRE( static_cast<const data_t&>(bins[k]) == static_cast<const data_t&>(expected[k]) );
+        }
+    };
+
+    const auto bins = cache.bins(b, points, 1);
+    REQUIRE( cache.misses() == 1 );
+    same_bins(*bins);
+    REQUIRE( cache.bins(b, points, 1) == bins );
+    REQUIRE( cache.hits() == 1 );
+
+    // extent doesn't affect unclipped results - shared entry
+    cache.bins(b.extent({{{10, 10}, {90, 90}}}), points, 1);
+    REQUIRE( cache.hits() == 2 );
+
+    // other version, radius, clipped extent or kind of result - other entries
+    cache.bins(b, points, 2);
+    cache.bins(b.radius(4), points, 1);
+    cache.bins(b.clip(true), points, 1);
+    cache.bins(b.extent({{{20, 20}, {80, 80}}}), points, 1);
+    const auto counts = cache.counts(b, points, 1);
+    REQUIRE( cache.misses() == 6 );
+    REQUIRE( cache.size() == 6 );
+    const auto expected = b.counts(points);
+    REQUIRE( counts->size() == expected.size() );
+    for(std::size_t k = 0; k < expected.size(); ++k) {
+        REQUIRE( (*counts)[k].x == expected[k].x );
+        REQUIRE( (*counts)[k].count == expected[k].count );
+    }
+    REQUIRE( cache.bytes() <= cache.budget() );
+
+    // engine doesn't change results
+    REQUIRE( cache.counts(b.engine(d3_hexbin::HexbinEngine::sort), points, 1) == counts );
+    REQUIRE( cache.hits() == 3 );
+
+    cache.invalidate(1);
+    REQUIRE( cache.size() == 1 );
+    cache.clear();
+    REQUIRE( cache.size() == 0 );
+    REQUIRE( cache.bytes() == 0 );
+
+    // LRU eviction under budget
+    d3_hexbin::HexbinCache<decltype(b)> small(2 * sizeof(std::vector<d3_hexbin::HexbinCount<double>>)
+                                              + 2 * expected.capacity() * sizeof(d3_hexbin::HexbinCount<double>) + 64);
+    small.counts(b, points, 1);
+    small.counts(b, points, 2);
+    small.counts(b, points, 1); // 1 is most recently used
+    small.counts(b, points, 3); // evicts 2
+    REQUIRE( small.evictions() == 1 );
+    REQUIRE( small.size() == 2 );
+    small.counts(b, points, 1);
+    REQUIRE( small.hits() == 2 );
+    small.counts(b, points, 2);
+    REQUIRE( small.misses() == 4 );
+
+    // result, larger than budget, is not cached
+    d3_hexbin::HexbinCache<decltype(b)> tiny(16);
+    same_bins(*tiny.bins(b, points, 1));
+    REQUIRE( tiny.size() == 0 );
+}
+
+// Datum, which counts its copies & moves
+struct Counted {
+    static std::size_t copies;
+    static std::size_t moves;
+
+    double x, y;
+
+    Counted(double x_, double y_) : x(x_), y(y_) {}
+    Counted(const Counted& other) : x(other.x), y(other.y) { ++copies; }
+    Counted(Counted&& other) noexcept : x(other.x), y(other.y) { ++moves; }
+    Counted& operator = (const Counted& other) { x = other.x; y = other.y; ++copies; return *this; }
+    Counted& operator = (Counted&& other) noexcept { x = other.x; y = other.y; ++moves; return *this; }
+
+    double operator [] (std::size_t i) const { return (i == 0) ? x : y; }
+    bool operator == (const Counted& other) const { return x == other.x && y == other.y; }
+};
+
+std::size_t Counted::copies = 0;
+std::size_t Counted::moves  = 0;
+
+TEST_CASE("hexbin(points) copies each point only once") {
+    const auto random = randomPoints(3000, -15, 15);
+    std::vector<Counted> points;
+    points.reserve(random.size() + 1);
+    for(const auto& p : random) points.emplace_back(p[0], p[1]);
+    points.emplace_back(std::numeric_limits<double>::quiet_NaN(), 0); // skipped
+
+    const std::size_t binned = random.size();
+
+    for(const auto engine : {d3_hexbin::HexbinEngine::hash, d3_hexbin::HexbinEngine::dense, d3_hexbin::HexbinEngine::sort})
+    for(const auto order : {d3_hexbin::HexbinOrder::by_id, d3_hexbin::HexbinOrder::first_seen}) {
+        const auto b = d3_hexbin::hexbin<Counted, double, point_t>().radius(0.9).engine(engine).order(order);
+
+        Counted::copies = Counted::moves = 0;
+        const auto bins = b(points);
+        REQUIRE( Counted::copies == binned );
+        REQUIRE( Counted::moves < 2 * binned ); // bins growth only
+
+        std::vector<Counted> moved(points);
+        Counted::copies = Counted::moves = 0;
+        const auto moved_bins = b(std::move(moved));
+        REQUIRE( Counted::copies == 0 );
+        REQUIRE( Counted::moves < 3 * binned ); // into bins & bins growth
+
+        REQUIRE( moved_bins.size() == bins.size() );
+        for(std::size_t k = 0; k < bins.size(); ++k) {
+            REQUIRE( moved_bins[k].size() == bins[k].size() );
+            REQUIRE( moved_bins[k].x == bins[k].x );
+            REQUIRE( moved_bins[k][0].x == bins[k][0].x );
+        }
+    }
+}
+
+TEST_CASE("HexbinAccumulator removes the oldest points of a hot bin in O(1)") {
+    const std::size_t n = 20000, window = 100;
+    std::vector<Counted> points;
+    points.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) points.emplace_back(i * 1e-6, 0); // all in one bin
+
+    auto acc = d3_hexbin::accumulator( d3_hexbin::hexbin<Counted, double, point_t>().radius(1) );
+    Counted::copies = Counted::moves = 0;
+    for(std::size_t i = 0; i < n; ++i) {
+        REQUIRE( acc.add(points[i]) );
+        if (i < window) continue;
+        if (i % 2) {
+            REQUIRE( acc.remove(points[i - window]) );
+        } else {
+            REQUIRE( acc.decrement(acc.ids().front()) );
+        }
+    }
+    REQUIRE( Counted::copies == n );
+    REQUIRE( Counted::moves < 4 * n ); // no shifting of whole bin per removal
+
+    const auto& bins = acc.snapshot();
+    REQUIRE( bins.size() == 1 );
+    REQUIRE( bins[0].size() == window );
+    for(std::size_t k = 0; k < window; ++k)
+        REQUIRE( bins[0][k].x == points[n - window + k].x );
+
+    for(std::size_t k = 0; k < window; ++k) REQUIRE( acc.decrement(acc.ids().front()) );
+    REQUIRE( acc.empty() );
+    REQUIRE( acc.snapshot().empty() );
+}
+
 TEST_CASE("hexbin.size() gets or sets the extent") {
     auto b = d3_hexbin::hexbin<datum_t, double, point_t>().size({2, 3});
     REQUIRE( b.extent() == extent_t{{ {0, 0}, {2, 3} }});